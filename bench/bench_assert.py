@@ -0,0 +1,195 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Code size and run time of va_assert.h against an inline-formatting ASSERT.
+
+A synthetic TU holds --asserts assertions, 10 per function, each on a
+different element of an array and a different bound, so no two are merged
+and none fail. It is built once per variant and shape:
+
+- naive: if (!(cond)) { fprintf(stderr, ...); abort(); }, with a second
+  fprintf(stderr, ": " __VA_ARGS__) for the message added through VA_OPT
+- va_assert: VA_ASSERT, a branch and a call to a cold handler
+- off: VA_ASSERT under NDEBUG, where nothing is evaluated
+
+The "plain" shape has no message; "message" passes "a[%d] = %d" and two
+ints. Sizes come from the TU's object file: hot is .text, cold is
+.text.unlikely, where GCC and Clang move the failure blocks, and rodata
+counts the strings and site descriptors. ns_per_assert times a loop that
+calls every function, so the hot code of the whole TU goes through the
+instruction cache on each pass.
+
+    python3 bench/bench_assert.py --asserts 10000 --opts -O2 -Os
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+import ppbench
+
+VARIANTS = {
+    "naive": ["-DBENCH_NAIVE"],
+    "va_assert": [],
+    "off": ["-DNDEBUG"],
+}
+
+SHAPES = {
+    "plain": "ASSERT(a[%(k)d] < %(bound)d);",
+    "message": 'ASSERT(a[%(k)d] < %(bound)d, "a[%%d] = %%d", %(k)d, '
+               "a[%(k)d]);",
+}
+
+PER_FUNCTION = 10
+ELEMENTS = 64
+
+ASSERTS = r"""
+#include <stdlib.h>
+#include "va_assert.h"
+
+#ifdef BENCH_NAIVE
+    #define ASSERT(cond, ...)                                                  \
+      do {                                                                     \
+        if (!(cond)) {                                                         \
+          fprintf(stderr, "%%s:%%d: %%s: Assertion `%%s' failed", __FILE__,    \
+                  __LINE__, __func__, #cond);                                  \
+          VA_OPT((__VA_ARGS__), fprintf(stderr, ": " __VA_ARGS__);)            \
+          fputc('\n', stderr);                                                 \
+          abort();                                                             \
+        }                                                                      \
+      } while (0)
+#else
+    #define ASSERT VA_ASSERT
+#endif
+
+%s
+
+int (*const bench_fns[])(const int *) = {%s};
+const int bench_nfns = %d;
+"""
+
+MAIN = r"""
+#define VA_ASSERT_IMPLEMENTATION
+#include <stdlib.h>
+#include <time.h>
+#include "va_assert.h"
+
+extern int (*const bench_fns[])(const int *);
+extern const int bench_nfns;
+
+int main(int argc, char **argv) {
+  static int a[%d];
+  long r, reps = atol(argv[1]);
+  int i, sum = 0;
+  struct timespec t0, t1;
+  for (i = 0; i < (int)(sizeof(a) / sizeof(a[0])); i++) {
+    a[i] = argc + i;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (r = 0; r < reps; r++) {
+    for (i = 0; i < bench_nfns; i++) {
+      sum += bench_fns[i](a);
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  printf("%%.3f %%d\n", ((t1.tv_sec - t0.tv_sec) * 1e9 +
+                         (t1.tv_nsec - t0.tv_nsec)) /
+                            ((double)reps * bench_nfns * %d), sum & 1);
+  return 0;
+}
+"""
+
+
+def generate(shape, count):
+    fns = []
+    bodies = []
+    for f in range(count // PER_FUNCTION):
+        lines = []
+        for m in range(PER_FUNCTION):
+            n = f * PER_FUNCTION + m
+            k = n % ELEMENTS
+            lines.append("  " + SHAPES[shape] % {"k": k,
+                                                 "bound": ELEMENTS + 1 + n})
+            lines.append("  s += a[%d];" % k)
+        bodies.append("int bench_f%d(const int *a) {\n  int s = 0;\n%s\n"
+                      "  return s;\n}" % (f, "\n".join(lines)))
+        fns.append("bench_f%d" % f)
+    return ASSERTS % ("\n".join(bodies), ", ".join(fns), len(fns))
+
+
+def sections(obj):
+    """Return (hot, cold, rodata) bytes from `size -A`."""
+    hot = cold = rodata = 0
+    for line in subprocess.check_output(["size", "-A", obj]).decode() \
+            .splitlines():
+        parts = line.split()
+        if len(parts) < 2 or not parts[1].isdigit():
+            continue
+        name, size = parts[0], int(parts[1])
+        if name == ".text":
+            hot += size
+        elif name.startswith(".text.unlikely"):
+            cold += size
+        elif name.startswith(".rodata") or name.startswith(".data.rel.ro"):
+            rodata += size
+    return hot, cold, rodata
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None, help="compiler driver (default $CC)")
+    ap.add_argument("--opts", nargs="+", default=["-O2", "-Os"])
+    ap.add_argument("--variants", nargs="+", default=list(VARIANTS),
+                    choices=list(VARIANTS))
+    ap.add_argument("--shapes", nargs="+", default=list(SHAPES),
+                    choices=list(SHAPES))
+    ap.add_argument("--asserts", type=int, default=10000,
+                    help="assertions in the TU, a multiple of %d"
+                    % PER_FUNCTION)
+    ap.add_argument("--reps", type=int, default=200,
+                    help="passes over every function per run")
+    ap.add_argument("--repeat", type=int, default=3)
+    ap.add_argument("--out", default="-")
+    args = ap.parse_args()
+
+    cc = ppbench.split_cc(args.cc)
+    workdir = tempfile.mkdtemp(prefix=".bench_", dir=ppbench.ROOT)
+    rows = []
+    try:
+        main_c = os.path.join(workdir, "main.c")
+        with open(main_c, "w") as f:
+            f.write(MAIN % (ELEMENTS, PER_FUNCTION))
+        for shape in args.shapes:
+            src = os.path.join(workdir, "asserts_%s.c" % shape)
+            with open(src, "w") as f:
+                f.write(generate(shape, args.asserts))
+            for opt in args.opts:
+                main_o = os.path.join(workdir, "main%s.o" % opt)
+                if not os.path.exists(main_o):
+                    subprocess.check_call(cc + [opt, "-c", "-I", ppbench.ROOT,
+                                                main_c, "-o", main_o])
+                for variant in args.variants:
+                    stem = os.path.join(workdir, "%s_%s%s" % (shape, variant,
+                                                              opt))
+                    subprocess.check_call(cc + [
+                        opt, "-c", "-I", ppbench.ROOT, src, "-o",
+                        stem + ".o"] + VARIANTS[variant])
+                    subprocess.check_call(cc + [main_o, stem + ".o", "-o",
+                                                stem])
+                    hot, cold, rodata = sections(stem + ".o")
+                    ns = min(float(subprocess.check_output(
+                        [stem, str(args.reps)]).decode().split()[0])
+                        for _ in range(max(1, args.repeat)))
+                    rows.append([opt, shape, variant, args.asserts, hot,
+                                 cold, rodata, "%.3f" % ns])
+    finally:
+        shutil.rmtree(workdir)
+    ppbench.write_csv(args.out, ["opt", "shape", "variant", "asserts",
+                                 "hot_bytes", "cold_bytes", "rodata_bytes",
+                                 "ns_per_assert"], rows)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,250 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Compare the cost of every VA_* macro against bench/baseline.csv.
+
+Each public macro is measured per forced implementation and per argument shape
+(the SINGLE, VARIADIC and NARGS case lists of the built-in test suite):
+
+- expansions, scanned and peak_tokens come from the counting expander in
+  ppexpand.py. They do not depend on the machine, so they are compared
+  against --threshold exactly.
+- us_per_call and max_rss_kb come from `cc -E` over a TU that repeats the
+  shape's cases, taking the least CPU time of --repeat runs. After each run a
+  calibration TU that does not use va_opt.h is timed too, and the baseline's
+  time is scaled by the change in calibrate_us. That keeps a baseline recorded
+  on another machine, or under different load, usable. Timing is still
+  noisier than the counts, so it has its own --time-threshold, and a shape
+  that looks slower is timed again with twice the runs before it counts.
+
+With --update the results are written to the baseline file, and each TU gets
+enough calls to scan about --tokens tokens. Otherwise the TUs get the
+baseline's call counts, and the script fails if any metric grew by more than
+its threshold.
+
+    python3 bench/bench_check.py --threshold 5 --time-threshold 25
+    python3 bench/bench_check.py --time-threshold 0
+    python3 bench/bench_check.py --update
+"""
+
+import argparse
+import math
+import os
+import subprocess
+import sys
+
+import bench_pp
+import ppbench
+import ppexpand
+
+BASELINE = os.path.join(ppbench.ROOT, "bench", "baseline.csv")
+
+SHAPES = {
+    "single": "SINGLE_TEST_CASES",
+    "variadic": "VARIADIC_TEST_CASES",
+    "nargs": "NARGS_TEST_CASES",
+}
+
+# Macro -> (invocation over __VA_ARGS__, shapes it is measured on)
+FORMS = {
+    "VA_ISEMPTY": ("VA_ISEMPTY(__VA_ARGS__)", ["single", "variadic"]),
+    "VA_NOTEMPTY": ("VA_NOTEMPTY(__VA_ARGS__)", ["single", "variadic"]),
+    "VA_OPT": ("1 VA_OPT((__VA_ARGS__), -1)", ["single", "variadic"]),
+    "VA_NOPT": ("0 VA_NOPT((__VA_ARGS__), +1)", ["single", "variadic"]),
+    "VA_OPT_ELSE": ("VA_OPT_ELSE((__VA_ARGS__), 0, 1)",
+                    ["single", "variadic"]),
+    "VA_NARGS": ("VA_NARGS(__VA_ARGS__)", ["single", "nargs"]),
+    "VA_OVERLOAD": ("VA_OVERLOAD(TEST_OVL, __VA_ARGS__)",
+                    ["single", "variadic", "nargs"]),
+    "VA_FOR_EACH": ("0 VA_FOR_EACH(TEST_EACH_ONE, __VA_ARGS__)", ["nargs"]),
+    "VA_MAP": ("VA_MAP(TEST_MAP_ONE, __VA_ARGS__)", ["nargs"]),
+}
+
+METRICS = ["expansions", "scanned", "peak_tokens", "us_per_call",
+           "max_rss_kb"]
+
+# Growth below this is noise rather than a regression.
+SLACK = {"us_per_call": 0.1, "max_rss_kb": 1024}
+
+CALIBRATION_CALLS = 100000
+
+HEADER = ["impl", "macro", "shape", "calls"] + METRICS + ["calibrate_us"]
+
+
+def count(ex, form, cases):
+    """Summed expansions and scanned tokens, and the largest peak."""
+    totals = [0, 0, 0]
+    for _, case in cases:
+        ex.reset()
+        ex.expand(ppexpand.tokenize(
+            form.replace("__VA_ARGS__", ppexpand.spell(case))))
+        totals[0] += sum(ex.expansions.values())
+        totals[1] += ex.scanned
+        totals[2] = max(totals[2], ex.peak)
+    return totals
+
+
+def run_cpu(cc, path, impl):
+    """CPU seconds and peak RSS of one `cc -E` run."""
+    argv = ppbench.split_cc(cc) + ["-E", "-P", "-I", ppbench.ROOT]
+    if impl is not None:
+        argv.append("-D" + ppbench.IMPLS[impl])
+    proc = subprocess.Popen(argv + [path], stdout=subprocess.DEVNULL)
+    _, status, usage = os.wait4(proc.pid, 0)
+    if os.waitstatus_to_exitcode(status) != 0:
+        raise RuntimeError("preprocessing failed: " + " ".join(argv))
+    return usage.ru_utime + usage.ru_stime, usage.ru_maxrss
+
+
+def calibration_tu(calls):
+    """A TU that does not include va_opt.h, to rate the machine's speed."""
+    lines = ["#define CAL_C(x) (x)", "#define CAL_B(x, y) CAL_C(y) + x",
+             "#define CAL_A(x) CAL_B(x, x)"]
+    lines += ["CAL_A(1) CAL_A(2) CAL_A(3) CAL_A(4)"] * (calls // 4)
+    return "\n".join(lines) + "\n"
+
+
+def timed(cc, source, impl, repeat):
+    """Least CPU seconds and largest RSS of `source`, and the least CPU
+    seconds of the calibration TU, run alternately so both see the same
+    machine load."""
+    path = os.path.join(ppbench.ROOT, ".bench_check_%d.c" % os.getpid())
+    cal = os.path.join(ppbench.ROOT, ".bench_check_%d_cal.c" % os.getpid())
+    with open(path, "w") as f:
+        f.write(source)
+    with open(cal, "w") as f:
+        f.write(calibration_tu(CALIBRATION_CALLS))
+    secs, rss, cal_secs = [], 0, []
+    try:
+        for _ in range(max(1, repeat)):
+            t, r = run_cpu(cc, path, impl)
+            secs.append(t)
+            rss = max(rss, r)
+            cal_secs.append(run_cpu(cc, cal, None)[0])
+    finally:
+        os.unlink(path)
+        os.unlink(cal)
+    return min(secs), rss, min(cal_secs)
+
+
+def measure(cc, impls, tokens, repeat, calls_from=None, only=None):
+    """One row per (impl, macro, shape), or per key in `only`. The number of
+    calls per timed TU is taken from `calls_from` (a baseline) when it has the
+    shape, otherwise picked so that the TU scans about `tokens` tokens. With
+    `repeat` 0 nothing is timed."""
+    calls_from = calls_from or {}
+    rows = []
+    for impl in impls:
+        macros = ppexpand.load_macros(cc, ppbench.HEADER, impl,
+                                      ["TEST_VA_OPT"])
+        ex = ppexpand.Expander(macros)
+        for macro, (form, shapes) in FORMS.items():
+            for shape in shapes:
+                if only is not None and (impl, macro, shape) not in only:
+                    continue
+                cases = ppexpand.test_cases(macros, SHAPES[shape])
+                counts = count(ex, form, cases)
+                n = calls_from.get((impl, macro, shape))
+                if n is None:
+                    n = tokens * len(cases) // max(1, counts[1])
+                reps = max(1, int(math.ceil(n / float(len(cases)))))
+                n = reps * len(cases)
+                if not repeat:
+                    rows.append([impl, macro, shape, n] + counts
+                                + ["-", "-", "-"])
+                    continue
+                secs, rss, cal = timed(
+                    cc, bench_pp.make_tu(form, SHAPES[shape], reps), impl,
+                    repeat)
+                rows.append([impl, macro, shape, n] + counts
+                            + ["%.4f" % (secs * 1e6 / n), rss,
+                               "%.4f" % (cal * 1e6 / CALIBRATION_CALLS)])
+    return rows
+
+
+def read_csv(path):
+    with open(path) as f:
+        lines = f.read().split()
+    header = lines[0].split(",")
+    return [dict(zip(header, line.split(","))) for line in lines[1:]]
+
+
+def compare(baseline, rows, threshold, time_threshold):
+    """Print the metrics that changed; return the regressions as
+    (impl, macro, shape, metric) tuples."""
+    base = dict(((r["impl"], r["macro"], r["shape"]), r) for r in baseline)
+    bad = []
+    for row in rows:
+        r = dict(zip(HEADER, [str(c) for c in row]))
+        old = base.get((r["impl"], r["macro"], r["shape"]))
+        if old is None:
+            sys.stderr.write("%-6s %-12s %-8s not in the baseline\n"
+                             % (r["impl"], r["macro"], r["shape"]))
+            continue
+        for metric in METRICS:
+            if r[metric] == "-":
+                continue
+            was = float(old[metric])
+            now = float(r[metric])
+            allowed = threshold
+            if metric == "us_per_call":
+                was *= float(r["calibrate_us"]) / float(old["calibrate_us"])
+                allowed = time_threshold
+            limit = was * (1 + allowed / 100.0) + SLACK.get(metric, 0)
+            if now > limit:
+                verdict = "REGRESSION"
+                bad.append((r["impl"], r["macro"], r["shape"], metric))
+            elif now != was and metric not in SLACK:
+                verdict = "changed"
+            else:
+                continue
+            sys.stderr.write("%-6s %-12s %-8s %-12s %10.3f -> %10.3f  %s\n"
+                             % (r["impl"], r["macro"], r["shape"], metric,
+                                was, now, verdict))
+    return bad
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None, help="compiler driver (default $CC)")
+    ap.add_argument("--impls", nargs="+", default=ppbench.DEFAULT_IMPLS,
+                    choices=sorted(ppbench.IMPLS))
+    ap.add_argument("--tokens", type=int, default=1000000,
+                    help="tokens scanned per timed TU, with --update")
+    ap.add_argument("--repeat", type=int, default=3)
+    ap.add_argument("--threshold", type=float, default=5.0,
+                    help="allowed growth of the counts and RSS, in percent")
+    ap.add_argument("--time-threshold", type=float, default=50.0,
+                    help="allowed growth of us_per_call in percent, "
+                    "0 to check only the counts")
+    ap.add_argument("--baseline", default=BASELINE)
+    ap.add_argument("--update", action="store_true",
+                    help="write the results to the baseline file")
+    args = ap.parse_args()
+
+    sys.setrecursionlimit(100000)
+    if args.update:
+        rows = measure(args.cc, args.impls, args.tokens, args.repeat)
+        ppbench.write_csv(args.baseline, HEADER, rows)
+        return 0
+    baseline = read_csv(args.baseline)
+    calls = dict(((r["impl"], r["macro"], r["shape"]), int(r["calls"]))
+                 for r in baseline)
+    rows = measure(args.cc, args.impls, args.tokens,
+                   args.repeat if args.time_threshold else 0, calls)
+    bad = compare(baseline, rows, args.threshold, args.time_threshold)
+    slow = set(b[:3] for b in bad if b[3] == "us_per_call")
+    if slow:
+        # A time regression has to show up again, with more runs, to count.
+        sys.stderr.write("timing %d shapes again\n" % len(slow))
+        bad = [b for b in bad if b[3] != "us_per_call"]
+        again = measure(args.cc, args.impls, args.tokens, 2 * args.repeat,
+                        calls, slow)
+        bad += [b for b in compare(baseline, again, args.threshold,
+                                   args.time_threshold)
+                if b[3] == "us_per_call"]
+    sys.stderr.write("%d invocation shapes, %d regressions\n"
+                     % (len(rows), len(bad)))
+    return 1 if bad else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
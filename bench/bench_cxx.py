@@ -0,0 +1,110 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Frontend time per VA_* call compiled as C, as C++, and inside templates.
+
+The TUs are those of bench_trace.py: functions whose bodies sum VA_* calls
+over the SINGLE_TEST_CASES and VARIADIC_TEST_CASES shapes, one TU per macro
+and forced implementation, less a baseline TU with each call replaced by its
+expected value. Each is compiled three ways:
+
+- c: plain functions, by the C compiler
+- c++: the same functions, by the C++ compiler
+- template: function templates, each explicitly instantiated, by the C++
+  compiler, so that template parsing and instantiation share the frontend
+  with the macros
+
+Macro expansion itself does not depend on the language, so a difference
+between the columns is overhead of the C++ frontend around the expanded
+tokens. The timers are those of bench_trace.py (clang -ftime-trace, gcc
+-ftime-report).
+
+    python3 bench/bench_cxx.py --cc gcc --cxx "g++ -std=c++17"
+"""
+
+import argparse
+import os
+import shutil
+import sys
+import tempfile
+
+import bench_trace
+import ppbench
+
+LANGS = ["c", "c++", "template"]
+
+
+def make_tu(body, functions, lang):
+    if lang != "template":
+        return bench_trace.make_tu(body, functions)
+    lines = ["#define TEST_VA_OPT", '#include "va_opt.h"', "#undef X",
+             "#define X(expected, ...) + (%s)" % body]
+    for i in range(functions):
+        lines.append("template <int I> int va_trace_%d() { return I "
+                     "SINGLE_TEST_CASES VARIADIC_TEST_CASES; }" % i)
+        lines.append("template int va_trace_%d<0>();" % i)
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None, help="C compiler (default $CC)")
+    ap.add_argument("--cxx", default=os.environ.get("CXX") or "c++",
+                    help="C++ compiler, with its -std (default $CXX)")
+    ap.add_argument("--impls", nargs="+", default=ppbench.DEFAULT_IMPLS,
+                    choices=sorted(ppbench.IMPLS))
+    ap.add_argument("--macros", nargs="+", default=list(bench_trace.FORMS),
+                    choices=list(bench_trace.FORMS))
+    ap.add_argument("--langs", nargs="+", default=LANGS, choices=LANGS)
+    ap.add_argument("--functions", type=int, default=1000,
+                    help="functions per TU, %d calls each"
+                    % bench_trace.CASES_PER_FUNCTION)
+    ap.add_argument("--repeat", type=int, default=3)
+    ap.add_argument("--out", default="-")
+    args = ap.parse_args()
+
+    calls = args.functions * bench_trace.CASES_PER_FUNCTION
+    workdir = tempfile.mkdtemp(prefix=".bench_", dir=ppbench.ROOT)
+    rows = []
+    summary = {}
+    try:
+        for lang in args.langs:
+            cc = args.cc if lang == "c" else args.cxx
+            timer = bench_trace.time_trace if bench_trace.is_clang(cc) \
+                else bench_trace.time_report
+            sources = {}
+            for name, body in [("none", bench_trace.BASELINE)] + \
+                    [(m, bench_trace.FORMS[m]) for m in args.macros]:
+                sources[name] = os.path.join(
+                    workdir, "%s_%s.%s" % (lang.replace("+", "x"), name,
+                                           "c" if lang == "c" else "cpp"))
+                with open(sources[name], "w") as f:
+                    f.write(make_tu(body, args.functions, lang))
+            for impl in args.impls:
+                base = bench_trace.best_of(args.repeat, timer, cc,
+                                           sources["none"], impl)[0]
+                rows.append([lang, impl, "none", calls, "%.1f" % base, "-",
+                             "-"])
+                for macro in args.macros:
+                    ms = bench_trace.best_of(args.repeat, timer, cc,
+                                             sources[macro], impl)[0]
+                    net = ms - base
+                    summary[lang, impl, macro] = net * 1e3 / calls
+                    rows.append([lang, impl, macro, calls, "%.1f" % ms,
+                                 "%.1f" % net, "%.3f" % (net * 1e3 / calls)])
+    finally:
+        shutil.rmtree(workdir)
+    ppbench.write_csv(args.out, ["lang", "impl", "macro", "invocations",
+                                 "frontend_ms", "net_ms", "us_per_call"],
+                      rows)
+    sys.stderr.write("net frontend us per call\n")
+    sys.stderr.write("%-22s" % "" + "".join("%10s" % l for l in args.langs)
+                     + "\n")
+    for impl in args.impls:
+        for macro in args.macros:
+            sys.stderr.write("%-22s" % ("%s %s" % (impl, macro)) + "".join(
+                "%10.3f" % summary[l, impl, macro] for l in args.langs)
+                + "\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
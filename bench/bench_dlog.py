@@ -0,0 +1,155 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Hot-path cost per call of va_dlog.h against synchronous fprintf.
+
+One program is built per variant. It starts T threads, and each one logs
+--calls records with N int arguments (N from 0 to 8) and reports the wall
+time of its loop. The result is the mean nanoseconds per call over the
+threads:
+
+- dlog: VA_DLOG_INFO into each thread's ring; the writer thread formats and
+  writes to /dev/null in the background, outside the timed loop's work
+- fprintf: fprintf(stream, "[INFO] " fmt "\\n", ...) on a shared, fully
+  buffered /dev/null stream, formatting and locking on the calling thread
+
+--calls is kept below what a thread's ring holds, so the dlog figures are
+the cost of the call itself. Once a ring fills up, a producer waits for the
+single writer and the two variants converge on the formatting rate.
+
+    python3 bench/bench_dlog.py --threads 1 4 32 --args 0 4 8
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+import ppbench
+
+VARIANTS = {
+    "dlog": [],
+    "fprintf": ["-DBENCH_FPRINTF"],
+}
+
+PROGRAM = r"""
+#define VA_DLOG_IMPLEMENTATION
+#include <stdlib.h>
+#include "va_dlog.h"
+
+static FILE *bench_stream;
+static long bench_calls;
+static int bench_nargs;
+
+#ifdef BENCH_FPRINTF
+    #define LOG(fmt, ...)                                                      \
+      fprintf(bench_stream, "[INFO] " fmt "\n" VA_OPT((__VA_ARGS__), ,)        \
+              __VA_ARGS__)
+#else
+    #define LOG(fmt, ...) VA_DLOG_INFO(fmt, __VA_ARGS__)
+#endif
+
+static double now_ns(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static void *bench_thread(void *out) {
+  long i;
+  int a = 1;
+  double t0 = now_ns();
+  switch (bench_nargs) {
+%s
+  }
+  *(double *)out = now_ns() - t0;
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  int t, threads = atoi(argv[1]);
+  double total = 0, *elapsed = calloc(threads, sizeof(double));
+  pthread_t *ids = calloc(threads, sizeof(pthread_t));
+  static char buf[1 << 16];
+  bench_nargs = atoi(argv[2]);
+  bench_calls = atol(argv[3]);
+  bench_stream = fopen("/dev/null", "w");
+  setvbuf(bench_stream, buf, _IOFBF, sizeof(buf));
+#ifndef BENCH_FPRINTF
+  va_dlog_start(bench_stream);
+#endif
+  for (t = 0; t < threads; t++) {
+    pthread_create(&ids[t], NULL, bench_thread, &elapsed[t]);
+  }
+  for (t = 0; t < threads; t++) {
+    pthread_join(ids[t], NULL);
+    total += elapsed[t];
+  }
+#ifndef BENCH_FPRINTF
+  va_dlog_stop();
+#endif
+  fclose(bench_stream);
+  printf("%%.2f\n", total / threads / bench_calls);
+  return 0;
+}
+"""
+
+MAX_ARGS = 8
+
+
+def case(n):
+    fmt = " ".join(["%d"] * n) or "no arguments"
+    args = "".join(", a + %d" % k for k in range(n))
+    return ("  case %d:\n    for (i = 0; i < bench_calls; i++) {\n"
+            "      LOG(\"%s\"%s);\n    }\n    break;" % (n, fmt, args))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None, help="compiler driver (default $CC)")
+    ap.add_argument("--opt", default="-O2")
+    ap.add_argument("--threads", nargs="+", type=int,
+                    default=[1, 2, 4, 8, 16, 32])
+    ap.add_argument("--args", nargs="+", type=int,
+                    default=list(range(MAX_ARGS + 1)),
+                    choices=range(MAX_ARGS + 1))
+    ap.add_argument("--variants", nargs="+", default=list(VARIANTS),
+                    choices=list(VARIANTS))
+    ap.add_argument("--calls", type=int, default=10000,
+                    help="records per thread; 8 ints take 88 bytes of the "
+                    "1 MiB ring")
+    ap.add_argument("--repeat", type=int, default=3)
+    ap.add_argument("--out", default="-")
+    args = ap.parse_args()
+
+    workdir = tempfile.mkdtemp(prefix=".bench_", dir=ppbench.ROOT)
+    rows = []
+    try:
+        src = os.path.join(workdir, "dlog.c")
+        with open(src, "w") as f:
+            f.write(PROGRAM % "\n".join(case(n)
+                                        for n in range(MAX_ARGS + 1)))
+        exes = {}
+        for variant in args.variants:
+            exes[variant] = os.path.join(workdir, "dlog_" + variant)
+            subprocess.check_call(ppbench.split_cc(args.cc) + [
+                args.opt, "-pthread", "-I", ppbench.ROOT, src, "-o",
+                exes[variant]] + VARIANTS[variant])
+        for threads in args.threads:
+            for n in args.args:
+                for variant in args.variants:
+                    ns = min(float(subprocess.check_output(
+                        [exes[variant], str(threads), str(n),
+                         str(args.calls)]).decode())
+                        for _ in range(max(1, args.repeat)))
+                    rows.append([variant, threads, n, args.calls,
+                                 "%.2f" % ns])
+    finally:
+        shutil.rmtree(workdir)
+    ppbench.write_csv(args.out, ["variant", "threads", "args",
+                                 "calls_per_thread", "ns_per_call"], rows)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,94 @@
+# SPDX-License-Identifier: CC0-1.0
+"""VA_FOR_EACH against the naive deferred-recursion FOR_EACH.
+
+The naive version re-invokes itself through a deferred FOR_EACH_AGAIN and
+relies on a fixed EVAL tower (3 + 9 + 27 + 81 = 120
+rescans) to drive the recursion, so
+every invocation pays for all rescans regardless of the list length.
+VA_FOR_EACH walks a chain of distinct step macros and stops as soon as
+VA_ISEMPTY reports an empty rest. Both apply the same macro to every element.
+
+    python3 bench/bench_each.py --cc gcc --counts 1 8 32 64 --max-each 64
+"""
+
+import argparse
+
+import ppbench
+
+# Deferred recursion with a fixed EVAL tower. The emptiness test is the same
+# VA_ISEMPTY, so only the recursion driver differs.
+NAIVE = "\n".join([
+    "#define NAIVE_PARENS ()",
+    "#define NAIVE_EVAL(...) NAIVE_EVAL4(NAIVE_EVAL4(NAIVE_EVAL4(__VA_ARGS__)))",
+    "#define NAIVE_EVAL4(...) NAIVE_EVAL3(NAIVE_EVAL3(NAIVE_EVAL3(__VA_ARGS__)))",
+    "#define NAIVE_EVAL3(...) NAIVE_EVAL2(NAIVE_EVAL2(NAIVE_EVAL2(__VA_ARGS__)))",
+    "#define NAIVE_EVAL2(...) NAIVE_EVAL1(NAIVE_EVAL1(NAIVE_EVAL1(__VA_ARGS__)))",
+    "#define NAIVE_EVAL1(...) __VA_ARGS__",
+    "#define NAIVE_FOR_EACH(m, ...) NAIVE_EVAL(NAIVE_HELPER(m, __VA_ARGS__))",
+    "#define NAIVE_HELPER(m, a, ...) \\",
+    "  m(a) NAIVE_NEXT(VA_ISEMPTY(__VA_ARGS__)) NAIVE_PARENS (m, __VA_ARGS__)",
+    "#define NAIVE_NEXT(isempty) NAIVE_CAT(NAIVE_NEXT_, isempty)",
+    "#define NAIVE_CAT(a, b) NAIVE_CAT_I(a, b)",
+    "#define NAIVE_CAT_I(a, b) a##b",
+    "#define NAIVE_NEXT_0 NAIVE_AGAIN",
+    "#define NAIVE_NEXT_1 NAIVE_STOP",
+    "#define NAIVE_AGAIN() NAIVE_HELPER",
+    "#define NAIVE_STOP() NAIVE_EAT",
+    "#define NAIVE_EAT(...)",
+    "#define BENCH_M(x) +x",
+])
+# One element per rescan plus the initial expansion; longer lists are left
+# partially expanded.
+NAIVE_LIMIT = 121
+
+LOOPS = {
+    "VA_FOR_EACH": "VA_FOR_EACH(BENCH_M, BENCH_ARGS)",
+    "naive": "NAIVE_FOR_EACH(BENCH_M, BENCH_ARGS)",
+}
+
+
+def make_tu(loop, nargs, calls, max_each):
+    lines = ["#define VA_OPT_MAX_EACH %d" % max_each, '#include "va_opt.h"',
+             NAIVE]
+    if loop is not None:
+        lines.append("#define BENCH_ARGS " +
+                     ", ".join("a%d" % i for i in range(nargs)))
+        lines += [LOOPS[loop]] * calls
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None, help="compiler driver (default $CC)")
+    ap.add_argument("--impls", nargs="+", default=ppbench.DEFAULT_IMPLS,
+                    choices=sorted(ppbench.IMPLS))
+    ap.add_argument("--counts", nargs="+", type=int, default=[1, 8, 32, 64, 121])
+    ap.add_argument("--calls", type=int, default=200,
+                    help="invocations per TU")
+    ap.add_argument("--max-each", type=int, default=128,
+                    help="VA_OPT_MAX_EACH for the TU")
+    ap.add_argument("--repeat", type=int, default=3)
+    ap.add_argument("--out", default="-")
+    args = ap.parse_args()
+
+    rows = []
+    for impl in args.impls:
+        base, _, _ = ppbench.best_of(args.repeat, ppbench.run_pp, args.cc,
+                                     make_tu(None, 0, 0, args.max_each), impl)
+        for n in args.counts:
+            for loop in LOOPS:
+                if loop == "naive" and n > NAIVE_LIMIT:
+                    continue
+                if loop == "VA_FOR_EACH" and n > args.max_each:
+                    continue
+                src = make_tu(loop, n, args.calls, args.max_each)
+                secs, rss, _ = ppbench.best_of(args.repeat, ppbench.run_pp,
+                                               args.cc, src, impl)
+                rows.append([impl, loop, n, args.calls, "%.4f" % secs, rss,
+                             "%.3f" % ((secs - base) * 1e6 / args.calls)])
+    ppbench.write_csv(args.out, ["impl", "loop", "nargs", "invocations",
+                                 "seconds", "max_rss_kb", "us_per_call"], rows)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,115 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Macro expansions and scanned tokens per VA_ISEMPTY call.
+
+Replays every ISEMPTY_TEST_CASES entry through the counting expander in
+ppexpand.py and reports, per case, how many macros were expanded and how many
+tokens were scanned. The expander output is checked against `cc -E` and the
+result against the expected value, so a faster header cannot pass by being
+wrong. --revs compares the working tree (".") with headers from git revisions.
+
+    python3 bench/bench_expand.py --revs HEAD . --impls c99
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+import ppbench
+import ppexpand
+
+MACROS = {
+    "VA_ISEMPTY": "VA_ISEMPTY(%s)",
+    "VA_NOTEMPTY": "VA_NOTEMPTY(%s)",
+    "VA_OPT": "VA_OPT((%s), 1)",
+    "VA_NOPT": "VA_NOPT((%s), 1)",
+    "VA_OPT_ELSE": "VA_OPT_ELSE((%s), 1, 0)",
+    "VA_IF_EMPTY_ELSE": "VA_IF_EMPTY_ELSE((%s), 1, 0)",
+    "VA_WITH_EMPTINESS": "VA_WITH_EMPTINESS((%s), TEST_BIT, ~)",
+}
+CASE_LISTS = ["SINGLE_TEST_CASES", "VARIADIC_TEST_CASES"]
+
+
+def checkout(rev, workdir):
+    """Path to va_opt.h as of `rev` ("." is the working tree)."""
+    if rev == ".":
+        return ppbench.HEADER
+    path = os.path.join(workdir, rev.replace("/", "_"), "va_opt.h")
+    os.makedirs(os.path.dirname(path))
+    with open(path, "wb") as f:
+        f.write(subprocess.check_output(["git", "show", rev + ":va_opt.h"],
+                                        cwd=ppbench.ROOT))
+    return path
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None, help="compiler driver (default $CC)")
+    ap.add_argument("--impls", nargs="+", default=["c99"],
+                    choices=sorted(ppbench.IMPLS))
+    ap.add_argument("--revs", nargs="+", default=["."],
+                    help='git revisions to compare, "." is the working tree')
+    ap.add_argument("--macros", nargs="+", default=["VA_ISEMPTY"],
+                    choices=list(MACROS))
+    ap.add_argument("--out", default="-")
+    args = ap.parse_args()
+
+    sys.setrecursionlimit(100000)
+    workdir = tempfile.mkdtemp(prefix=".bench_", dir=ppbench.ROOT)
+    rows = []
+    totals = []
+    bad = []
+    try:
+        for rev in args.revs:
+            header = checkout(rev, workdir)
+            for impl in args.impls:
+                macros = ppexpand.load_macros(args.cc, header, impl,
+                                              ["TEST_VA_OPT"])
+                cases = []
+                for name in CASE_LISTS:
+                    cases += ppexpand.split_cases(macros[name].body)
+                ex = ppexpand.Expander(macros)
+                for macro in args.macros:
+                    sums = [0, 0]
+                    sources = []
+                    outputs = []
+                    for expected, case in cases:
+                        src = MACROS[macro] % ppexpand.spell(case)
+                        ex.reset()
+                        out = ex.expand(ppexpand.tokenize(src))
+                        got = ppexpand.spell(out)
+                        if macro == "VA_ISEMPTY" and got != expected or \
+                                macro == "VA_NOTEMPTY" and got == expected:
+                            bad.append("%s %s %s: %s gave %s"
+                                       % (rev, impl, macro, src, got))
+                        sources.append(src)
+                        outputs += out
+                        total = sum(ex.expansions.values())
+                        sums[0] += total
+                        sums[1] += ex.scanned
+                        rows.append([rev, impl, macro,
+                                     ppexpand.spell(case) or "<empty>", got,
+                                     total, ex.scanned])
+                    if not ppexpand.verify_tokens(args.cc, header, impl,
+                                                  "\n".join(sources), outputs,
+                                                  ["TEST_VA_OPT"]):
+                        bad.append("%s %s %s: expander disagrees with cc -E"
+                                   % (rev, impl, macro))
+                    rows.append([rev, impl, macro, "<total>", "-"] + sums)
+                    totals.append((rev, impl, macro, sums))
+    finally:
+        shutil.rmtree(workdir)
+    ppbench.write_csv(args.out, ["rev", "impl", "macro", "case", "result",
+                                 "expansions", "scanned"], rows)
+    for rev, impl, macro, (n, s) in totals:
+        sys.stderr.write("%-10s %-6s %-17s %6d expansions %7d tokens\n"
+                         % (rev, impl, macro, n, s))
+    for b in bad:
+        sys.stderr.write("error: %s\n" % b)
+    return 1 if bad else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
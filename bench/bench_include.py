@@ -0,0 +1,131 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Include cost of va_opt.h against the slim per-implementation headers.
+
+Builds the same small translation unit (the header plus a handful of VA_*
+calls) many times with `cc -fsyntax-only`, once per header, the way a large
+project pays for the header in every TU. CPU time is summed over the compiler
+processes from wait4(); a row with header "none" builds the TU without any
+header and is subtracted from the others' net_ms_per_tu.
+
+The slim headers are generated into a temporary directory by
+tools/slim_header.py.
+
+    python3 bench/bench_include.py --cc gcc --tus 5000
+"""
+
+import argparse
+import concurrent.futures
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+import ppbench
+
+BODY = """\
+#define LOG(fmt, ...) log_(fmt VA_OPT((__VA_ARGS__), ,) __VA_ARGS__)
+void log_(const char *fmt, ...);
+int f(void) {
+  LOG("a");
+  LOG("b %d", 1);
+  return VA_NARGS(a, b, c) + VA_ISEMPTY();
+}
+"""
+
+
+def compile_once(argv):
+    proc = subprocess.Popen(argv, stderr=subprocess.PIPE)
+    _, status, usage = os.wait4(proc.pid, 0)
+    err = proc.stderr.read()
+    proc.stderr.close()
+    if os.waitstatus_to_exitcode(status) != 0:
+        sys.stderr.write(err.decode(errors="replace"))
+        raise RuntimeError("compile failed: " + " ".join(argv))
+    return usage.ru_utime + usage.ru_stime
+
+
+def build(jobs, variants, tus):
+    """Compile every variant `tus` times, interleaved so that drift in machine
+    load is shared; returns the summed CPU seconds per variant."""
+    work = [(name, argv) for _ in range(tus) for name, argv in variants]
+    cpu = dict.fromkeys([name for name, _ in variants], 0.0)
+    with concurrent.futures.ThreadPoolExecutor(jobs) as pool:
+        times = pool.map(compile_once, [argv for _, argv in work])
+        for (name, _), t in zip(work, times):
+            cpu[name] += t
+    return cpu
+
+
+def command(cc, include_dir, impl, tu):
+    argv = ppbench.split_cc(cc) + ["-fsyntax-only", "-I", include_dir]
+    if impl is not None:
+        argv.append("-D" + ppbench.IMPLS[impl])
+    return argv + [tu]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None, help="compiler driver (default $CC)")
+    ap.add_argument("--impls", nargs="+", default=ppbench.DEFAULT_IMPLS,
+                    choices=ppbench.DEFAULT_IMPLS)
+    ap.add_argument("--tus", type=int, default=5000,
+                    help="translation units per header")
+    ap.add_argument("--jobs", type=int, default=os.cpu_count() or 1)
+    ap.add_argument("--out", default="-")
+    args = ap.parse_args()
+
+    workdir = tempfile.mkdtemp(prefix=".bench_", dir=ppbench.ROOT)
+    rows = []
+    try:
+        gen = [sys.executable,
+               os.path.join(ppbench.ROOT, "tools", "slim_header.py"),
+               "--out-dir", workdir, "--impls"] + args.impls
+        if args.cc:
+            gen += ["--cc", args.cc]
+        subprocess.check_call(gen)
+        sources = {"none": "int f(void) { return 0; }\n"}
+        headers = {"va_opt.h": ppbench.HEADER}
+        for impl in args.impls:
+            name = "va_opt_%s.h" % impl
+            headers[name] = os.path.join(workdir, name)
+        for name in headers:
+            sources[name] = '#include "%s"\n%s' % (name, BODY)
+        for name, text in sources.items():
+            with open(os.path.join(workdir, name + ".c"), "w") as f:
+                f.write(text)
+
+        def tu(name):
+            return os.path.join(workdir, name + ".c")
+
+        variants = []
+        for name in ["none"] + [n for n in headers if n != "va_opt.h"]:
+            variants.append((name, command(args.cc, workdir, None, tu(name))))
+        for impl in args.impls:
+            variants.append(("va_opt.h:" + impl, command(
+                args.cc, ppbench.ROOT, impl, tu("va_opt.h"))))
+        start = time.perf_counter()
+        cpu = build(args.jobs, variants, args.tus)
+        wall = time.perf_counter() - start
+        base = cpu["none"]
+        rows.append(["-", "none", 0, args.tus, "%.2f" % base,
+                     "%.3f" % (base * 1e3 / args.tus), "-"])
+        for impl in args.impls:
+            for name in ["va_opt.h", "va_opt_%s.h" % impl]:
+                key = name + ":" + impl if name == "va_opt.h" else name
+                rows.append([impl, name, os.path.getsize(headers[name]),
+                             args.tus, "%.2f" % cpu[key],
+                             "%.3f" % (cpu[key] * 1e3 / args.tus),
+                             "%.3f" % ((cpu[key] - base) * 1e3 / args.tus)])
+        sys.stderr.write("%d compiles in %.1f s\n"
+                         % (args.tus * len(variants), wall))
+    finally:
+        shutil.rmtree(workdir)
+    ppbench.write_csv(args.out, ["impl", "header", "header_bytes", "tus",
+                                 "cpu_seconds", "ms_per_tu", "net_ms_per_tu"],
+                      rows)
+
+
+if __name__ == "__main__":
+    main()
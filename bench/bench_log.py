@@ -0,0 +1,124 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Run-time cost per call of va_log.h against naive fprintf logging.
+
+One program per variant logs a fixed mix of messages in a loop to /dev/null
+through a fully buffered FILE and prints nanoseconds per call:
+
+- naive: fprintf(stream, "[INFO] " fmt "\n" VA_OPT((...), ,) ...) for every
+  call, the header's headline LOG example
+- va_log: VA_LOG_INFO, which sends calls without arguments to fwrite
+- off: VA_LOG_INFO with VA_LOG_LEVEL_OFF, where nothing is evaluated
+
+Each shape is timed on its own: "plain" calls have no format arguments,
+"args" calls pass an int and a string. Compilers already turn a constant
+fprintf without conversions into fwrite when optimizing, so compare at the
+optimization levels of interest (--opts).
+
+    python3 bench/bench_log.py --opts -O0 -O2 --calls 2000000
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+import ppbench
+
+VARIANTS = {
+    "naive": ["-DBENCH_NAIVE"],
+    "va_log": [],
+    "off": ["-DVA_LOG_LEVEL=VA_LOG_LEVEL_OFF"],
+}
+
+SHAPES = {
+    "plain": ['LOG("request done");', 'LOG("cache flushed, 0 entries");'],
+    "args": ['LOG("status %d", (int)i);', 'LOG("user %s id %d", name, '
+             '(int)(i & 0xff));'],
+}
+
+PROGRAM = r"""
+#include <stdlib.h>
+#include <time.h>
+#include "va_log.h"
+
+static FILE *bench_stream;
+#undef VA_LOG_STREAM
+#define VA_LOG_STREAM bench_stream
+
+#ifdef BENCH_NAIVE
+    #define LOG(fmt, ...)                                                      \
+      fprintf(bench_stream, "[INFO] " fmt "\n" VA_OPT((__VA_ARGS__), ,)        \
+              __VA_ARGS__)
+#else
+    #define LOG(fmt, ...) VA_LOG_INFO(fmt, __VA_ARGS__)
+#endif
+
+int main(int argc, char **argv) {
+  long i, n = argc > 1 ? atol(argv[1]) : 1000000;
+  const char *volatile name = "alice";
+  struct timespec t0, t1;
+  static char buf[1 << 16];
+  bench_stream = fopen("/dev/null", "w");
+  setvbuf(bench_stream, buf, _IOFBF, sizeof(buf));
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (i = 0; i < n; i++) {
+    %s
+  }
+  fflush(bench_stream);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  (void)name;
+  printf("%%.2f\n", ((t1.tv_sec - t0.tv_sec) * 1e9 +
+                     (t1.tv_nsec - t0.tv_nsec)) / (n * %d.0));
+  return 0;
+}
+"""
+
+
+def build(cc, workdir, shape, variant, opt):
+    src = os.path.join(workdir, "log_%s.c" % shape)
+    if not os.path.exists(src):
+        with open(src, "w") as f:
+            f.write(PROGRAM % ("\n    ".join(SHAPES[shape]),
+                               len(SHAPES[shape])))
+    exe = os.path.join(workdir, "log_%s_%s%s" % (shape, variant, opt))
+    subprocess.check_call(ppbench.split_cc(cc) + [
+        opt, "-I", ppbench.ROOT, src, "-o", exe] + VARIANTS[variant])
+    return exe
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None, help="compiler driver (default $CC)")
+    ap.add_argument("--opts", nargs="+", default=["-O0", "-O2"])
+    ap.add_argument("--variants", nargs="+", default=list(VARIANTS),
+                    choices=list(VARIANTS))
+    ap.add_argument("--calls", type=int, default=2000000,
+                    help="loop iterations per run")
+    ap.add_argument("--repeat", type=int, default=3)
+    ap.add_argument("--out", default="-")
+    args = ap.parse_args()
+
+    workdir = tempfile.mkdtemp(prefix=".bench_", dir=ppbench.ROOT)
+    rows = []
+    try:
+        for opt in args.opts:
+            for shape in SHAPES:
+                for variant in args.variants:
+                    exe = build(args.cc, workdir, shape, variant, opt)
+                    ns = min(float(subprocess.check_output(
+                        [exe, str(args.calls)]).decode())
+                        for _ in range(max(1, args.repeat)))
+                    rows.append([opt, shape, variant,
+                                 args.calls * len(SHAPES[shape]),
+                                 "%.2f" % ns])
+    finally:
+        shutil.rmtree(workdir)
+    ppbench.write_csv(args.out, ["opt", "shape", "variant", "calls",
+                                 "ns_per_call"], rows)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,74 @@
+# SPDX-License-Identifier: CC0-1.0
+"""VA_NARGS against the classic 64-argument PP_NARG.
+
+Both counters run over the same argument lists for counts PP_NARG supports;
+above that only VA_NARGS is measured. Each TU holds a fixed number of
+invocations (scaled down above 64 arguments) and is preprocessed once per
+forced implementation.
+
+    python3 bench/bench_nargs.py --cc gcc --counts 1 8 63 1000
+"""
+
+import argparse
+
+import ppbench
+
+# Classic PP_NARG (Laurent Deniau, comp.std.c 2006), sized for 64 arguments.
+PP_NARG_LIMIT = 63
+PP_NARG = "\n".join([
+    "#define PP_NARG(...) PP_NARG_(__VA_ARGS__, PP_RSEQ_N())",
+    "#define PP_NARG_(...) PP_ARG_N(__VA_ARGS__)",
+    "#define PP_ARG_N(%s, N, ...) N" % ", ".join(
+        "_%d" % i for i in range(1, 65)),
+    "#define PP_RSEQ_N() %s" % ", ".join(str(i) for i in range(64, -1, -1)),
+])
+
+COUNTERS = {
+    "VA_NARGS": "VA_NARGS(BENCH_ARGS)",
+    "PP_NARG": "PP_NARG(BENCH_ARGS)",
+}
+
+
+def make_tu(counter, nargs, calls):
+    lines = ['#include "va_opt.h"', PP_NARG]
+    if counter is not None:
+        lines.append("#define BENCH_ARGS " +
+                     ", ".join("a%d" % i for i in range(nargs)))
+        lines += [COUNTERS[counter]] * calls
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None, help="compiler driver (default $CC)")
+    ap.add_argument("--impls", nargs="+", default=ppbench.DEFAULT_IMPLS,
+                    choices=sorted(ppbench.IMPLS))
+    ap.add_argument("--counts", nargs="+", type=int,
+                    default=[1, 8, 32, 63, 100, 1000, 10000])
+    ap.add_argument("--calls", type=int, default=1000,
+                    help="invocations per TU")
+    ap.add_argument("--repeat", type=int, default=3)
+    ap.add_argument("--out", default="-")
+    args = ap.parse_args()
+
+    rows = []
+    for impl in args.impls:
+        base, _, _ = ppbench.best_of(args.repeat, ppbench.run_pp, args.cc,
+                                     make_tu(None, 0, 0), impl)
+        for n in args.counts:
+            for counter in COUNTERS:
+                if counter == "PP_NARG" and n > PP_NARG_LIMIT:
+                    continue
+                # Long lists cost more per call; keep TU runtimes comparable.
+                calls = max(1, args.calls * 64 // max(n, 64))
+                secs, rss, _ = ppbench.best_of(args.repeat, ppbench.run_pp,
+                                               args.cc,
+                                               make_tu(counter, n, calls), impl)
+                rows.append([impl, counter, n, calls, "%.4f" % secs, rss,
+                             "%.3f" % ((secs - base) * 1e6 / calls)])
+    ppbench.write_csv(args.out, ["impl", "counter", "nargs", "invocations",
+                                 "seconds", "max_rss_kb", "us_per_call"], rows)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,138 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Bytes and tokens of `cc -E` output per VA_* invocation.
+
+Each public macro is expanded over the SINGLE, VARIADIC and NARGS case lists of
+the built-in test suite, once per forced implementation and mode, and the
+output is compared with a TU that includes the header but makes no calls. Per
+invocation this reports:
+
+- bytes: the calls' share of `cc -E -P` output
+- wire_bytes: the same with line markers, as shipped by a distributed build
+- tokens: the number of preprocessing tokens
+- ideal_bytes: those tokens with a space only where two tokens would
+  otherwise lex as one; bytes - ideal_bytes is spacing left by the expansion
+
+The "log" form puts VA_OPT in a printf call site, the common case. Mode
+"minimal" defines VA_OPT_MINIMAL_OUTPUT.
+
+    python3 bench/bench_output.py --modes default minimal --out out.csv
+"""
+
+import argparse
+import subprocess
+import sys
+import tempfile
+
+import bench_pp
+import ppbench
+import ppexpand
+
+SHAPES = {
+    "single": "SINGLE_TEST_CASES",
+    "variadic": "VARIADIC_TEST_CASES",
+    "nargs": "NARGS_TEST_CASES",
+    "long": "NARGS_LONG_TEST_CASES",
+}
+
+# Macro -> (invocation over __VA_ARGS__, shapes it is measured on)
+FORMS = {
+    "log": ('printf("%d" VA_OPT((__VA_ARGS__), ,) __VA_ARGS__);',
+            ["single", "variadic"]),
+    "VA_ISEMPTY": ("VA_ISEMPTY(__VA_ARGS__)", ["single", "variadic"]),
+    "VA_OPT": ("VA_OPT((__VA_ARGS__), x, y)", ["single", "variadic"]),
+    "VA_NOPT": ("VA_NOPT((__VA_ARGS__), x, y)", ["single", "variadic"]),
+    "VA_OPT_ELSE": ("VA_OPT_ELSE((__VA_ARGS__), t, e, f)",
+                    ["single", "variadic"]),
+    "VA_WITH_EMPTINESS": ("VA_WITH_EMPTINESS((__VA_ARGS__), TEST_BIT_OPT, ~)",
+                          ["single", "variadic"]),
+    "VA_NARGS": ("VA_NARGS(__VA_ARGS__)", ["nargs", "long"]),
+    "VA_OVERLOAD": ("VA_OVERLOAD(TEST_OVL, __VA_ARGS__)", ["nargs"]),
+    "VA_FOR_EACH": ("VA_FOR_EACH(TEST_EACH_ONE, __VA_ARGS__)", ["nargs"]),
+    "VA_MAP": ("VA_MAP(TEST_MAP_ONE, __VA_ARGS__)", ["nargs"]),
+}
+
+MODES = {"default": [], "minimal": ["VA_OPT_MINIMAL_OUTPUT"]}
+
+
+def preprocess(cc, source, impl, defines, markers):
+    argv = ppbench.split_cc(cc) + ["-E", "-I", ppbench.ROOT,
+                                   "-D" + ppbench.IMPLS[impl]]
+    argv += ["-D" + d for d in defines] + ([] if markers else ["-P"])
+    with tempfile.NamedTemporaryFile("w", suffix=".c", dir=ppbench.ROOT,
+                                     prefix=".bench_") as f:
+        f.write(source)
+        f.flush()
+        return subprocess.check_output(argv + [f.name]).decode()
+
+
+def ideal_bytes(tokens):
+    """Length of the tightest spelling that lexes back to `tokens`."""
+    size = 0
+    for prev, tok in zip([None] + tokens, tokens):
+        size += len(tok.text)
+        if prev is not None and [t.text for t in ppexpand.tokenize(
+                prev.text + tok.text)] != [prev.text, tok.text]:
+            size += 1
+    return size
+
+
+def count_cases(cc, impl, shape):
+    macros = ppexpand.load_macros(cc, ppbench.HEADER, impl, ["TEST_VA_OPT"])
+    return len(ppexpand.test_cases(macros, SHAPES[shape]))
+
+
+def measure(cc, impl, defines, form, shape, reps, cases):
+    base = bench_pp.make_tu(None, None, 0)
+    src = bench_pp.make_tu(form, SHAPES[shape], reps)
+    calls = reps * cases
+    row = []
+    for markers in (False, True):
+        empty = preprocess(cc, base, impl, defines, markers)
+        out = preprocess(cc, src, impl, defines, markers)
+        row.append((len(out) - len(empty)) / float(calls))
+        if not markers:
+            # The calls come last; their output is what follows the prefix.
+            tail = out[len(empty.rstrip("\n")):] \
+                if out.startswith(empty.rstrip("\n")) else out
+            tokens = ppexpand.tokenize(tail)
+            row += [len(tokens) / float(calls),
+                    ideal_bytes(tokens) / float(calls)]
+    return row[0], row[3], row[1], row[2]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None, help="compiler driver (default $CC)")
+    ap.add_argument("--impls", nargs="+", default=ppbench.DEFAULT_IMPLS,
+                    choices=sorted(ppbench.IMPLS))
+    ap.add_argument("--modes", nargs="+", default=list(MODES),
+                    choices=list(MODES))
+    ap.add_argument("--macros", nargs="+", default=list(FORMS),
+                    choices=list(FORMS))
+    ap.add_argument("--reps", type=int, default=100,
+                    help="copies of each case list per TU")
+    ap.add_argument("--out", default="-")
+    args = ap.parse_args()
+
+    rows = []
+    for impl in args.impls:
+        counts = dict((s, count_cases(args.cc, impl, s)) for s in SHAPES)
+        for mode in args.modes:
+            for macro in args.macros:
+                form, shapes = FORMS[macro]
+                for shape in shapes:
+                    size, wire, tokens, ideal = measure(
+                        args.cc, impl, MODES[mode], form, shape, args.reps,
+                        counts[shape])
+                    rows.append([impl, mode, macro, shape,
+                                 args.reps * counts[shape], "%.2f" % size,
+                                 "%.2f" % wire, "%.2f" % tokens,
+                                 "%.2f" % ideal])
+    ppbench.write_csv(args.out, ["impl", "mode", "macro", "shape", "calls",
+                                 "bytes", "wire_bytes", "tokens",
+                                 "ideal_bytes"], rows)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,84 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Preprocessing throughput of the public VA_* macros per implementation.
+
+Generates translation units with N invocations of VA_ISEMPTY, VA_NOTEMPTY,
+VA_OPT and VA_NOPT over the SINGLE_TEST_CASES and VARIADIC_TEST_CASES argument
+shapes from the header's own test suite, times `cc -E` for each forced
+implementation and writes one CSV row per run.
+
+Each TU is built with TEST_VA_OPT so it pays for <stdio.h> and the built-in
+test main. A row with macro "none" and 0 invocations measures that fixed cost
+and is subtracted from the other rows' us_per_call.
+
+    python3 bench/bench_pp.py --cc gcc --sizes 1000 10000 --out bench_pp.csv
+"""
+
+import argparse
+import math
+
+import ppbench
+
+MACROS = {
+    "VA_ISEMPTY": "VA_ISEMPTY(__VA_ARGS__)",
+    "VA_NOTEMPTY": "VA_NOTEMPTY(__VA_ARGS__)",
+    "VA_OPT": "VA_OPT((__VA_ARGS__), -1)",
+    "VA_NOPT": "VA_NOPT((__VA_ARGS__), +1)",
+    # if/else: two emptiness tests versus one
+    "VA_NOPT_VA_OPT": "VA_NOPT((__VA_ARGS__), +1) VA_OPT((__VA_ARGS__), -1)",
+    "VA_OPT_ELSE": "VA_OPT_ELSE((__VA_ARGS__), -1, +1)",
+}
+DEFAULT_MACROS = ["VA_ISEMPTY", "VA_NOTEMPTY", "VA_OPT", "VA_NOPT"]
+
+# Shape name -> (case list macro, number of X() entries in it)
+SHAPES = {
+    "single": ("SINGLE_TEST_CASES", 15),
+    "variadic": ("VARIADIC_TEST_CASES", 6),
+}
+
+
+def make_tu(body, cases, reps):
+    lines = ["#define TEST_VA_OPT", '#include "va_opt.h"', "#undef X"]
+    if body is not None:
+        lines.append("#define X(expected, ...) " + body)
+        lines += [cases] * reps
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None, help="compiler driver (default $CC)")
+    ap.add_argument("--impls", nargs="+", default=ppbench.DEFAULT_IMPLS,
+                    choices=sorted(ppbench.IMPLS))
+    ap.add_argument("--sizes", nargs="+", type=int,
+                    default=[1000, 10000, 100000, 1000000])
+    ap.add_argument("--macros", nargs="+", default=DEFAULT_MACROS,
+                    choices=list(MACROS))
+    ap.add_argument("--shapes", nargs="+", default=list(SHAPES),
+                    choices=list(SHAPES))
+    ap.add_argument("--repeat", type=int, default=3)
+    ap.add_argument("--out", default="-")
+    args = ap.parse_args()
+
+    rows = []
+    for impl in args.impls:
+        base, rss, size = ppbench.best_of(args.repeat, ppbench.run_pp,
+                                          args.cc, make_tu(None, None, 0), impl)
+        rows.append([impl, "none", "-", 0, "%.4f" % base, rss, size, "-"])
+        for macro in args.macros:
+            for shape in args.shapes:
+                cases, width = SHAPES[shape]
+                for n in args.sizes:
+                    reps = int(math.ceil(n / float(width)))
+                    src = make_tu(MACROS[macro], cases, reps)
+                    secs, rss, size = ppbench.best_of(
+                        args.repeat, ppbench.run_pp, args.cc, src, impl)
+                    calls = reps * width
+                    rows.append([impl, macro, shape, calls, "%.4f" % secs, rss,
+                                 size, "%.3f" % ((secs - base) * 1e6 / calls)])
+    ppbench.write_csv(args.out, ["impl", "macro", "shape", "invocations",
+                                 "seconds", "max_rss_kb", "out_bytes",
+                                 "us_per_call"], rows)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,126 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Run-time cost per call of va_print.h against fprintf on log-style lines.
+
+One program per variant writes one line shape in a loop to /dev/null
+through a fully buffered FILE and prints nanoseconds per call:
+
+- printf: fprintf(stream, fmt, ...)
+- va_print: VA_FPRINT(stream, fmt, ...), fwrite without arguments and a
+  chain of typed writers for one to four
+
+Each shape is timed on its own. "literal" has no arguments; "fallback" has
+five, which VA_FPRINT hands to fprintf, and shows the cost of the dispatch
+alone. Compilers already turn a constant fprintf without conversions into
+fwrite when optimizing, so compare at the optimization levels of interest
+(--opts).
+
+    python3 bench/bench_print.py --opts=-O2 --calls 1000000
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+import ppbench
+
+VARIANTS = {
+    "printf": ["-DBENCH_PRINTF"],
+    "va_print": [],
+}
+
+SHAPES = {
+    "literal": 'PRINT("server listening on the admin socket\\n");',
+    "string": 'PRINT("GET %s\\n", path);',
+    "int": 'PRINT("worker %d started\\n", (int)(i & 0xff));',
+    "request": 'PRINT("%s %s %d %zu\\n", method, path, 200, (size_t)i);',
+    "timing": 'PRINT("request %ld took %.3f ms\\n", i, (double)i / 7);',
+    "fallback": 'PRINT("%s %s %d %zu %d\\n", method, path, 200, (size_t)i, '
+                '(int)(i & 7));',
+}
+
+PROGRAM = r"""
+#define VA_PRINT_IMPLEMENTATION
+#include <stdlib.h>
+#include <time.h>
+#include "va_print.h"
+
+static FILE *bench_stream;
+
+#ifdef BENCH_PRINTF
+    #define PRINT(...) fprintf(bench_stream, __VA_ARGS__)
+#else
+    #define PRINT(...) VA_FPRINT(bench_stream, __VA_ARGS__)
+#endif
+
+int main(int argc, char **argv) {
+  long i, n = argc > 1 ? atol(argv[1]) : 1000000;
+  const char *volatile path = "/api/v1/users/1234/profile";
+  const char *volatile method = "GET";
+  struct timespec t0, t1;
+  static char buf[1 << 16];
+  bench_stream = fopen("/dev/null", "w");
+  setvbuf(bench_stream, buf, _IOFBF, sizeof(buf));
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (i = 0; i < n; i++) {
+    %s
+  }
+  fflush(bench_stream);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  (void)path;
+  (void)method;
+  printf("%%.2f\n", ((t1.tv_sec - t0.tv_sec) * 1e9 +
+                     (t1.tv_nsec - t0.tv_nsec)) / n);
+  return 0;
+}
+"""
+
+
+def build(cc, workdir, shape, variant, opt):
+    src = os.path.join(workdir, "print_%s.c" % shape)
+    if not os.path.exists(src):
+        with open(src, "w") as f:
+            f.write(PROGRAM % SHAPES[shape])
+    exe = os.path.join(workdir, "print_%s_%s%s" % (shape, variant, opt))
+    subprocess.check_call(ppbench.split_cc(cc) + [
+        opt, "-I", ppbench.ROOT, src, "-o", exe] + VARIANTS[variant])
+    return exe
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None, help="compiler driver (default $CC)")
+    ap.add_argument("--opts", nargs="+", default=["-O0", "-O2"])
+    ap.add_argument("--variants", nargs="+", default=list(VARIANTS),
+                    choices=list(VARIANTS))
+    ap.add_argument("--shapes", nargs="+", default=list(SHAPES),
+                    choices=list(SHAPES))
+    ap.add_argument("--calls", type=int, default=1000000,
+                    help="loop iterations per run")
+    ap.add_argument("--repeat", type=int, default=3)
+    ap.add_argument("--out", default="-")
+    args = ap.parse_args()
+
+    workdir = tempfile.mkdtemp(prefix=".bench_", dir=ppbench.ROOT)
+    rows = []
+    try:
+        for opt in args.opts:
+            for shape in args.shapes:
+                for variant in args.variants:
+                    exe = build(args.cc, workdir, shape, variant, opt)
+                    ns = min(float(subprocess.check_output(
+                        [exe, str(args.calls)]).decode())
+                        for _ in range(max(1, args.repeat)))
+                    rows.append([opt, shape, variant, args.calls,
+                                 "%.2f" % ns])
+    finally:
+        shutil.rmtree(workdir)
+    ppbench.write_csv(args.out, ["opt", "shape", "variant", "calls",
+                                 "ns_per_call"], rows)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,98 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Cost of VA_ISEMPTY / VA_OPT against the number of forwarded arguments.
+
+The sentinel-based NTRNLVA_HAS_COMMA and NTRNLVA_ISEMPTY_I accept any number
+of arguments. This sweeps the argument count N, preprocessing a fixed number
+of invocations per TU for each forced implementation, and reports time and
+peak RSS against N.
+
+With --check, the growth exponent of the C99 path between the two largest N
+is estimated from the baseline-corrected times and the script exits non-zero
+if it exceeds --max-exponent (1.0 is linear).
+
+    python3 bench/bench_scale.py --cc gcc --counts 100 1000 10000
+    python3 bench/bench_scale.py --impls c99 --check
+"""
+
+import argparse
+import math
+import sys
+
+import ppbench
+
+MACROS = {
+    "VA_ISEMPTY": "VA_ISEMPTY(%s)",
+    "VA_OPT": "VA_OPT((%s), -1)",
+}
+
+
+def make_tu(template, nargs, calls):
+    # The list is spelled once and forwarded through BENCH_ARGS so the
+    # generated source (and this process' RSS, see ppbench.run_pp) stays small.
+    lines = ['#include "va_opt.h"']
+    if template is not None:
+        lines.append("#define BENCH_ARGS " +
+                     ", ".join("a%d" % i for i in range(nargs)))
+        lines += [template % "BENCH_ARGS"] * calls
+    return "\n".join(lines) + "\n"
+
+
+def growth_exponent(points):
+    """Slope of log(time) over log(N) between the two largest N."""
+    (n1, t1), (n2, t2) = sorted(points)[-2:]
+    if t1 <= 0 or t2 <= 0:
+        return None
+    return math.log(t2 / t1) / math.log(float(n2) / n1)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None, help="compiler driver (default $CC)")
+    ap.add_argument("--impls", nargs="+", default=ppbench.DEFAULT_IMPLS,
+                    choices=sorted(ppbench.IMPLS))
+    ap.add_argument("--counts", nargs="+", type=int,
+                    default=[1, 10, 100, 1000, 10000])
+    ap.add_argument("--calls", type=int, default=100,
+                    help="invocations per TU")
+    ap.add_argument("--macros", nargs="+", default=list(MACROS),
+                    choices=list(MACROS))
+    ap.add_argument("--repeat", type=int, default=3)
+    ap.add_argument("--out", default="-")
+    ap.add_argument("--check", action="store_true",
+                    help="fail on superlinear growth in the C99 path")
+    ap.add_argument("--max-exponent", type=float, default=1.25)
+    args = ap.parse_args()
+
+    rows = []
+    failures = []
+    for impl in args.impls:
+        base, _, _ = ppbench.best_of(args.repeat, ppbench.run_pp, args.cc,
+                                     make_tu(None, 0, 0), impl)
+        for macro in args.macros:
+            points = []
+            for n in args.counts:
+                src = make_tu(MACROS[macro], n, args.calls)
+                secs, rss, size = ppbench.best_of(args.repeat, ppbench.run_pp,
+                                                  args.cc, src, impl)
+                net = secs - base
+                points.append((n, net))
+                rows.append([impl, macro, n, args.calls, "%.4f" % secs, rss,
+                             "%.3f" % (net * 1e6 / args.calls)])
+            exp = growth_exponent(points)
+            sys.stderr.write("%s %s: growth exponent %s\n" % (
+                impl, macro, "n/a" if exp is None else "%.2f" % exp))
+            if impl == "c99" and exp is not None and exp > args.max_exponent:
+                failures.append("%s %s grows as N^%.2f" % (impl, macro, exp))
+    ppbench.write_csv(args.out, ["impl", "macro", "nargs", "invocations",
+                                 "seconds", "max_rss_kb", "us_per_call"], rows)
+    if args.check:
+        for f in failures:
+            sys.stderr.write("superlinear: %s (limit N^%.2f)\n"
+                             % (f, args.max_exponent))
+        if failures:
+            return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
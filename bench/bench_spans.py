@@ -0,0 +1,106 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Per-span overhead of va_trace.h in enabled and disabled builds.
+
+One program is built per variant and runs a loop of --calls iterations of a
+single shape, printing nanoseconds per iteration:
+
+- plain: VA_TRACE_SCOPE("span") around an empty block
+- attrs: VA_TRACE_SCOPE("span", ("i", i), ("name", name))
+- event: VA_TRACE_EVENT("tick")
+
+The "enabled" variant records into the thread's buffer; "disabled" defines
+VA_TRACE_DISABLE and is the cost of the loop alone. The buffer limits are
+raised to hold --calls spans, so no record is dropped.
+
+    python3 bench/bench_spans.py --calls 50000 --opt -O2
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+import ppbench
+
+VARIANTS = {
+    "enabled": [],
+    "disabled": ["-DVA_TRACE_DISABLE"],
+}
+
+SHAPES = {
+    "plain": 'VA_TRACE_SCOPE("span");',
+    "attrs": 'VA_TRACE_SCOPE("span", ("i", i), ("name", name));',
+    "event": 'VA_TRACE_EVENT("tick");',
+}
+
+PROGRAM = r"""
+#define VA_TRACE_IMPLEMENTATION
+#include <stdlib.h>
+#include "va_trace.h"
+
+int main(int argc, char **argv) {
+  long i, n = atol(argv[2]);
+  const char *volatile name = "alice";
+  unsigned long long t0, t1;
+  (void)name;
+  t0 = va_trace_now();
+  switch (atoi(argv[1])) {
+%s
+  }
+  t1 = va_trace_now();
+  if (va_trace_dropped()) {
+    fprintf(stderr, "%%lu records dropped\n", va_trace_dropped());
+    return 1;
+  }
+  printf("%%.2f\n", (double)(t1 - t0) / n);
+  return 0;
+}
+"""
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None, help="compiler driver (default $CC)")
+    ap.add_argument("--opt", default="-O2")
+    ap.add_argument("--variants", nargs="+", default=list(VARIANTS),
+                    choices=list(VARIANTS))
+    ap.add_argument("--calls", type=int, default=50000,
+                    help="spans per run")
+    ap.add_argument("--repeat", type=int, default=3)
+    ap.add_argument("--out", default="-")
+    args = ap.parse_args()
+
+    workdir = tempfile.mkdtemp(prefix=".bench_", dir=ppbench.ROOT)
+    rows = []
+    try:
+        src = os.path.join(workdir, "spans.c")
+        cases = []
+        for k, shape in enumerate(SHAPES):
+            cases.append("  case %d:\n    for (i = 0; i < n; i++) {\n"
+                         "      %s\n    }\n    break;" % (k, SHAPES[shape]))
+        with open(src, "w") as f:
+            f.write(PROGRAM % "\n".join(cases))
+        for variant in args.variants:
+            exe = os.path.join(workdir, "spans_" + variant)
+            subprocess.check_call(ppbench.split_cc(args.cc) + [
+                args.opt, "-pthread", "-I", ppbench.ROOT, src, "-o", exe,
+                "-DVA_TRACE_MAX_EVENTS=%d" % args.calls,
+                "-DVA_TRACE_MAX_ATTRS=%d" % (2 * args.calls),
+                "-DVA_TRACE_MAX_STRINGS=%d" % (8 * args.calls)]
+                + VARIANTS[variant])
+            for k, shape in enumerate(SHAPES):
+                ns = min(float(subprocess.check_output(
+                    [exe, str(k), str(args.calls)]).decode())
+                    for _ in range(max(1, args.repeat)))
+                rows.append([variant, shape, args.calls, "%.2f" % ns])
+    finally:
+        shutil.rmtree(workdir)
+    ppbench.write_csv(args.out, ["variant", "shape", "calls",
+                                 "ns_per_span"], rows)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,145 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Frontend time of VA_OPT, VA_NOPT, VA_ISEMPTY and VA_NOTEMPTY per call.
+
+Unlike bench_pp.py, which times `cc -E` alone, this compiles real functions
+whose bodies are sums of VA_* calls over the SINGLE_TEST_CASES and
+VARIADIC_TEST_CASES shapes, and reads the compiler's own timers. With clang
+that is the "Frontend" event of the -ftime-trace JSON. With gcc it is the
+"phase parsing" and "preprocessing" lines of -ftime-report.
+
+Neither timer breaks macro expansion down by macro, so every macro gets a TU
+of its own per forced implementation. A baseline TU has the same functions
+with each call replaced by its expected value. The difference between the two
+is the frontend time spent in that macro.
+
+    python3 bench/bench_trace.py --cc clang --functions 1000
+"""
+
+import argparse
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+import ppbench
+
+FORMS = {
+    "VA_OPT": "1 VA_OPT((__VA_ARGS__), -1)",
+    "VA_NOPT": "0 VA_NOPT((__VA_ARGS__), +1)",
+    "VA_ISEMPTY": "VA_ISEMPTY(__VA_ARGS__)",
+    "VA_NOTEMPTY": "VA_NOTEMPTY(__VA_ARGS__)",
+}
+BASELINE = "expected"
+
+# X() entries in SINGLE_TEST_CASES plus VARIADIC_TEST_CASES
+CASES_PER_FUNCTION = 21
+
+_REPORT = re.compile(r"^ (phase parsing|preprocessing)\s+:.*?"
+                     r"([\d.]+) \(\s*\d+%\)\s+\S+ \(\s*\d+%\)$", re.M)
+
+
+def make_tu(body, functions):
+    lines = ["#define TEST_VA_OPT", '#include "va_opt.h"', "#undef X",
+             "#define X(expected, ...) + (%s)" % body]
+    for i in range(functions):
+        lines.append("int va_trace_%d(void) { return 0 SINGLE_TEST_CASES "
+                     "VARIADIC_TEST_CASES; }" % i)
+    return "\n".join(lines) + "\n"
+
+
+def is_clang(cc):
+    out = subprocess.check_output(ppbench.split_cc(cc) +
+                                  ["-x", "c", "-E", "-dM", os.devnull])
+    return b"#define __clang__ " in out
+
+
+def time_trace(cc, path, impl):
+    """Milliseconds in clang's Frontend event."""
+    obj = os.path.splitext(path)[0] + ".o"
+    subprocess.check_call(ppbench.split_cc(cc) + [
+        "-c", "-ftime-trace", "-I", ppbench.ROOT, "-D" + ppbench.IMPLS[impl],
+        path, "-o", obj])
+    with open(os.path.splitext(path)[0] + ".json") as f:
+        events = json.load(f)["traceEvents"]
+    total = [e["dur"] for e in events if e.get("name") == "Total Frontend"]
+    if not total:
+        total = [sum(e["dur"] for e in events if e.get("name") == "Frontend")]
+    return total[0] / 1e3, None
+
+
+def time_report(cc, path, impl):
+    """Milliseconds (wall) in gcc's parsing phase and its preprocessing part."""
+    proc = subprocess.run(ppbench.split_cc(cc) + [
+        "-fsyntax-only", "-ftime-report", "-I", ppbench.ROOT,
+        "-D" + ppbench.IMPLS[impl], path], stderr=subprocess.PIPE, check=True)
+    found = dict((m.group(1), float(m.group(2)) * 1e3)
+                 for m in _REPORT.finditer(proc.stderr.decode()))
+    return found.get("phase parsing", 0.0), found.get("preprocessing", 0.0)
+
+
+def best_of(repeat, fn, *args):
+    runs = [fn(*args) for _ in range(max(1, repeat))]
+    return min(runs, key=lambda r: r[0])
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None, help="compiler driver (default $CC)")
+    ap.add_argument("--impls", nargs="+", default=ppbench.DEFAULT_IMPLS,
+                    choices=sorted(ppbench.IMPLS))
+    ap.add_argument("--macros", nargs="+", default=list(FORMS),
+                    choices=list(FORMS))
+    ap.add_argument("--functions", type=int, default=1000,
+                    help="functions per TU, %d calls each"
+                    % CASES_PER_FUNCTION)
+    ap.add_argument("--repeat", type=int, default=3)
+    ap.add_argument("--out", default="-")
+    args = ap.parse_args()
+
+    timer = time_trace if is_clang(args.cc) else time_report
+    calls = args.functions * CASES_PER_FUNCTION
+    workdir = tempfile.mkdtemp(prefix=".bench_", dir=ppbench.ROOT)
+    rows = []
+    summary = {}
+    try:
+        sources = {}
+        for name, body in [("none", BASELINE)] + \
+                [(m, FORMS[m]) for m in args.macros]:
+            sources[name] = os.path.join(workdir, "trace_%s.c" % name)
+            with open(sources[name], "w") as f:
+                f.write(make_tu(body, args.functions))
+        for impl in args.impls:
+            base, base_pp = best_of(args.repeat, timer, args.cc,
+                                    sources["none"], impl)
+            rows.append([impl, "none", calls, "%.1f" % base,
+                         "-" if base_pp is None else "%.1f" % base_pp, "-",
+                         "-"])
+            for macro in args.macros:
+                ms, pp = best_of(args.repeat, timer, args.cc, sources[macro],
+                                 impl)
+                net = ms - base
+                summary[impl, macro] = net * 1e3 / calls
+                rows.append([impl, macro, calls, "%.1f" % ms,
+                             "-" if pp is None else "%.1f" % pp,
+                             "%.1f" % net, "%.3f" % (net * 1e3 / calls)])
+    finally:
+        shutil.rmtree(workdir)
+    ppbench.write_csv(args.out, ["impl", "macro", "invocations",
+                                 "frontend_ms", "preprocess_ms", "net_ms",
+                                 "us_per_call"], rows)
+    sys.stderr.write("net frontend us per call (%s)\n"
+                     % ("-ftime-trace" if timer is time_trace
+                        else "-ftime-report"))
+    sys.stderr.write("%-12s" % "" + "".join("%10s" % i for i in args.impls)
+                     + "\n")
+    for macro in args.macros:
+        sys.stderr.write("%-12s" % macro + "".join(
+            "%10.3f" % summary[i, macro] for i in args.impls) + "\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
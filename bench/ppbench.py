@@ -0,0 +1,90 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Shared helpers for the va_opt.h preprocessing benchmarks.
+
+Every benchmark in this directory works the same way: generate a synthetic
+translation unit that includes va_opt.h, run the preprocessor over it once per
+forced implementation and record wall time and peak RSS of the child process.
+"""
+
+import os
+import shlex
+import subprocess
+import sys
+import tempfile
+import time
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+HEADER = os.path.join(ROOT, "va_opt.h")
+
+# Forced implementation name -> define passed on the command line.
+IMPLS = {
+    "native": "VA_OPT_USE_NATIVE",
+    "gnu": "VA_OPT_USE_GNU",
+    "msvc": "VA_OPT_USE_MSVC",
+    "c99": "VA_OPT_USE_C99",
+}
+DEFAULT_IMPLS = ["native", "gnu", "c99"]
+
+
+def split_cc(cc):
+    """Split a CC string such as "ccache gcc" into an argv prefix."""
+    return shlex.split(cc or os.environ.get("CC") or "cc")
+
+
+def run_pp(cc, source, impl=None, flags=(), lang="c"):
+    """Preprocess `source` (C text) and return (seconds, max_rss_kb, out_bytes).
+
+    Peak RSS comes from wait4() on the compiler driver so each run is measured
+    on its own rather than accumulated over RUSAGE_CHILDREN. Linux folds the
+    forking process' high-water mark into the child's at exec, so the figure
+    never drops below this script's own RSS; keep generated sources small.
+    """
+    with tempfile.NamedTemporaryFile("w", suffix="." + lang, dir=ROOT,
+                                     prefix=".bench_", delete=False) as f:
+        f.write(source)
+        path = f.name
+    try:
+        argv = split_cc(cc) + ["-E", "-P", "-I", ROOT] + list(flags)
+        if impl is not None:
+            argv.append("-D" + IMPLS[impl])
+        argv.append(path)
+        with tempfile.TemporaryFile() as out, tempfile.TemporaryFile() as err:
+            start = time.perf_counter()
+            proc = subprocess.Popen(argv, stdout=out, stderr=err)
+            _, status, usage = os.wait4(proc.pid, 0)
+            elapsed = time.perf_counter() - start
+            proc.returncode = os.waitstatus_to_exitcode(status)
+            size = out.tell()
+            err.seek(0)
+            diag = err.read()
+    finally:
+        os.unlink(path)
+    if proc.returncode != 0:
+        sys.stderr.write(diag.decode(errors="replace"))
+        raise RuntimeError("preprocessing failed: " + " ".join(argv))
+    return elapsed, usage.ru_maxrss, size
+
+
+def best_of(repeat, fn, *args, **kwargs):
+    """Run `fn` `repeat` times, keep the fastest time and the largest RSS."""
+    best = None
+    for _ in range(max(1, repeat)):
+        secs, rss, size = fn(*args, **kwargs)
+        if best is None:
+            best = [secs, rss, size]
+        else:
+            best[0] = min(best[0], secs)
+            best[1] = max(best[1], rss)
+    return tuple(best)
+
+
+def write_csv(path, header, rows):
+    """Write rows to `path`, or to stdout when `path` is "-"."""
+    lines = [",".join(header)]
+    lines += [",".join(str(c) for c in row) for row in rows]
+    text = "\n".join(lines) + "\n"
+    if path == "-":
+        sys.stdout.write(text)
+    else:
+        with open(path, "w") as f:
+            f.write(text)
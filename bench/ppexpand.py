@@ -0,0 +1,374 @@
+# SPDX-License-Identifier: CC0-1.0
+"""A small macro expander that counts the work done by the preprocessor.
+
+Compilers do not report how many macros they expand, so this module replays
+the expansion itself. Definitions are taken from `cc -E -dM`, which leaves the
+header's #if selection to the real compiler; only #define semantics, argument
+prescan, rescanning, #, ## (with GNU comma elision) and __VA_OPT__ are modelled.
+Disabling follows GCC: a macro is disabled while its expansion is on the
+context stack and re-enabled once the rescan reads past its end, which is what
+the dispatch tables in va_opt.h rely on.
+
+Counts are per macro name: `expansions`, `rescanned` (tokens read back from
+the macro's replacement list) and `prescanned` (tokens read while expanding
+its arguments). `scanned` is the total number of tokens read, which is the
+cost the compiler actually pays, and `peak` the largest number of tokens
+waiting to be scanned at any one time. Use verify_tokens() to check the result
+against `cc -E`.
+"""
+
+import collections
+import re
+import subprocess
+
+import ppbench
+
+_TOKEN = re.compile(r"""
+    (?P<ws>\s+|/\*.*?\*/|//[^\n]*)
+  | (?P<id>[A-Za-z_]\w*)
+  | (?P<num>\.?\d(?:[eEpP][+-]|[\w.])*)
+  | (?P<str>"(?:\\.|[^"\\\n])*"|'(?:\\.|[^'\\\n])*')
+  | (?P<punct>\.\.\.|<<=|>>=|->|\+\+|--|<<|>>|<=|>=|==|!=|&&|\|\||
+              [*/%+\-&^|]=|\#\#|.)
+""", re.S | re.X)
+
+
+class Token(object):
+    __slots__ = ("text", "kind", "ws", "noexp")
+
+    def __init__(self, text, kind, ws=False, noexp=False):
+        self.text = text
+        self.kind = kind
+        self.ws = ws
+        self.noexp = noexp
+
+    def copy(self, ws=None, noexp=None):
+        return Token(self.text, self.kind, self.ws if ws is None else ws,
+                     self.noexp if noexp is None else noexp)
+
+    def __repr__(self):
+        return self.text
+
+
+PLACEMARKER = Token("", "placemarker")
+
+
+def tokenize(text):
+    tokens = []
+    ws = False
+    for m in _TOKEN.finditer(text):
+        kind = m.lastgroup
+        if kind == "ws":
+            ws = True
+            continue
+        tokens.append(Token(m.group(), kind, ws))
+        ws = False
+    return tokens
+
+
+class Macro(object):
+    def __init__(self, name, params, body):
+        self.name = name
+        self.params = params            # None for object-like macros
+        self.variadic = bool(params) and params[-1] == "__VA_ARGS__"
+        self.body = body
+
+
+def parse_defines(text):
+    """Parse `#define` lines as printed by `cc -E -dM`."""
+    macros = {}
+    for line in text.splitlines():
+        m = re.match(r"#define ([A-Za-z_]\w*)(\(([^)]*)\))? ?(.*)$", line)
+        if not m:
+            continue
+        params = None
+        if m.group(2):
+            params = [p.strip() for p in m.group(3).split(",") if p.strip()]
+            params = ["__VA_ARGS__" if p == "..." else p for p in params]
+        macros[m.group(1)] = Macro(m.group(1), params, tokenize(m.group(4)))
+    return macros
+
+
+class _Context(object):
+    __slots__ = ("macro", "tokens", "pos")
+
+    def __init__(self, macro, tokens):
+        self.macro = macro
+        self.tokens = tokens
+        self.pos = 0
+
+
+class Expander(object):
+    def __init__(self, macros):
+        self.macros = macros
+        self.expansions = collections.Counter()
+        self.rescanned = collections.Counter()
+        self.prescanned = collections.Counter()
+        self.scanned = 0
+        self.peak = 0
+        self._active = collections.Counter()
+        self._prescan = []
+        self._buffered = 0
+
+    def reset(self):
+        self.expansions.clear()
+        self.rescanned.clear()
+        self.prescanned.clear()
+        self.scanned = 0
+        self.peak = 0
+        self._prescan = []
+        self._buffered = 0
+
+    def expand(self, tokens):
+        return self._scan([self._context(None, list(tokens))])
+
+    def _context(self, macro, tokens):
+        self._buffered += len(tokens)
+        self.peak = max(self.peak, self._buffered)
+        return _Context(macro, tokens)
+
+    # -- token stream over a stack of contexts ------------------------------
+
+    def _pop_finished(self, stack):
+        while len(stack) > 1 and stack[-1].pos >= len(stack[-1].tokens):
+            self._active[stack.pop().macro] -= 1
+
+    def _peek(self, stack):
+        self._pop_finished(stack)
+        top = stack[-1]
+        if top.pos >= len(top.tokens):
+            return None
+        return top.tokens[top.pos]
+
+    def _next(self, stack):
+        tok = self._peek(stack)
+        if tok is not None:
+            stack[-1].pos += 1
+            self.scanned += 1
+            self._buffered -= 1
+            if stack[-1].macro is not None:
+                self.rescanned[stack[-1].macro] += 1
+            elif self._prescan:
+                self.prescanned[self._prescan[-1]] += 1
+        return tok
+
+    # -- expansion ----------------------------------------------------------
+
+    def _scan(self, stack):
+        out = []
+        while True:
+            tok = self._next(stack)
+            if tok is None:
+                return out
+            macro = None
+            if tok.kind == "id" and not tok.noexp:
+                macro = self.macros.get(tok.text)
+            if macro is None:
+                out.append(tok)
+                continue
+            if self._active[macro.name]:
+                out.append(tok.copy(noexp=True))
+                continue
+            if macro.params is None:
+                body = self._substitute(macro, {})
+            else:
+                nxt = self._peek(stack)
+                if nxt is None or nxt.text != "(":
+                    out.append(tok)
+                    continue
+                self._next(stack)
+                body = self._substitute(macro, self._collect(stack, macro))
+            self.expansions[macro.name] += 1
+            if body:
+                body[0] = body[0].copy(ws=tok.ws)
+            stack.append(self._context(macro.name, body))
+            self._active[macro.name] += 1
+
+    def _collect(self, stack, macro):
+        args = [[]]
+        depth = 0
+        while True:
+            tok = self._next(stack)
+            if tok is None:
+                raise ValueError("unterminated call to " + macro.name)
+            if tok.text == "(" and tok.kind == "punct":
+                depth += 1
+            elif tok.text == ")" and tok.kind == "punct":
+                if depth == 0:
+                    break
+                depth -= 1
+            elif tok.text == "," and tok.kind == "punct" and depth == 0 and \
+                    not (macro.variadic and len(args) >= len(macro.params)):
+                args.append([])
+                continue
+            args[-1].append(tok)
+        params = macro.params
+        if len(args) == 1 and not args[0] and not params:
+            args = []
+        if macro.variadic and len(args) == len(params) - 1:
+            args.append([])
+        if len(args) != len(params):
+            raise ValueError("%s expects %d arguments, got %d"
+                             % (macro.name, len(params), len(args)))
+        return dict(zip(params, args))
+
+    def _substitute(self, macro, args):
+        expanded = {}
+
+        def arg_expanded(name):
+            if name not in expanded:
+                self._prescan.append(macro.name)
+                try:
+                    expanded[name] = self._scan(
+                        [self._context(None, args[name])])
+                finally:
+                    self._prescan.pop()
+            return expanded[name]
+
+        def subst(body):
+            out = []
+            i = 0
+            while i < len(body):
+                tok = body[i]
+                prev_paste = out and out[-1] is _PASTE
+                next_paste = i + 1 < len(body) and body[i + 1].text == "##"
+                if tok.text == "##":
+                    out.append(_PASTE)
+                elif tok.text == "__VA_OPT__" and "__VA_ARGS__" in args:
+                    end = _matching(body, i + 1)
+                    if arg_expanded("__VA_ARGS__"):
+                        out += subst(body[i + 2:end]) or [PLACEMARKER]
+                    else:
+                        out.append(PLACEMARKER)
+                    i = end
+                elif tok.text == "#" and macro.params is not None and \
+                        i + 1 < len(body) and body[i + 1].text in args:
+                    i += 1
+                    out.append(_stringify(args[body[i].text], tok.ws))
+                elif tok.kind == "id" and tok.text in args:
+                    if prev_paste or next_paste:
+                        toks = [t.copy() for t in args[tok.text]]
+                    else:
+                        toks = [t.copy() for t in arg_expanded(tok.text)]
+                    if toks:
+                        toks[0].ws = tok.ws
+                    out += toks or [PLACEMARKER]
+                else:
+                    out.append(tok.copy())
+                i += 1
+            return out
+
+        return _paste(subst(macro.body), args)
+
+
+_PASTE = Token("##", "paste")
+
+
+def _matching(body, open_pos):
+    depth = 0
+    for j in range(open_pos, len(body)):
+        if body[j].text == "(":
+            depth += 1
+        elif body[j].text == ")":
+            depth -= 1
+            if depth == 0:
+                return j
+    raise ValueError("unbalanced __VA_OPT__")
+
+
+def _stringify(tokens, ws):
+    parts = []
+    for t in tokens:
+        text = t.text
+        if t.kind == "str":  # also covers character constants
+            text = text.replace("\\", "\\\\").replace('"', '\\"')
+        parts.append((" " if t.ws and parts else "") + text)
+    return Token('"%s"' % "".join(parts), "str", ws)
+
+
+def _paste(items, args):
+    out = []
+    i = 0
+    while i < len(items):
+        tok = items[i]
+        if tok is _PASTE and out and i + 1 < len(items):
+            right = items[i + 1]
+            left = out[-1]
+            va = args.get("__VA_ARGS__")
+            # GNU: `, ## __VA_ARGS__` drops the comma when no arguments are
+            # given and is a plain concatenation of the two otherwise.
+            if left.text == "," and va is not None and \
+                    right.kind == "placemarker" and not va:
+                out.pop()
+            elif left.kind == "placemarker":
+                out[-1] = right
+            elif right.kind != "placemarker":
+                if left.text == "," and va is not None:
+                    out.append(right)
+                else:
+                    merged = tokenize(left.text + right.text)
+                    merged[0].ws = left.ws
+                    out[-1:] = merged
+            i += 2
+            continue
+        out.append(tok)
+        i += 1
+    return [t for t in out if t.kind != "placemarker"]
+
+
+def spell(tokens):
+    return "".join((" " if t.ws and n else "") + t.text
+                   for n, t in enumerate(tokens))
+
+
+def split_cases(tokens):
+    """Split the body of an X-macro case list into (expected, args) pairs."""
+    cases = []
+    i = 0
+    while i < len(tokens):
+        if tokens[i].text != "X":
+            i += 1
+            continue
+        depth = 0
+        for j in range(i + 1, len(tokens)):
+            depth += {"(": 1, ")": -1}.get(tokens[j].text, 0)
+            if depth == 0:
+                break
+        inner = tokens[i + 2:j]
+        comma = [t.text for t in inner].index(",")
+        cases.append((" ".join(t.text for t in inner[:comma]),
+                      inner[comma + 1:]))
+        i = j + 1
+    return cases
+
+
+def test_cases(macros, name):
+    """The cases of an X-macro list, following lists that name other lists."""
+    body = macros[name].body
+    if any(t.text == "X" for t in body):
+        return split_cases(body)
+    return sum((test_cases(macros, t.text) for t in body), [])
+
+
+def load_macros(cc, header, impl, defines=()):
+    argv = ppbench.split_cc(cc) + ["-x", "c", "-E", "-dM"]
+    argv += ["-D" + d for d in defines]
+    if impl is not None:
+        argv.append("-D" + ppbench.IMPLS[impl])
+    text = subprocess.check_output(argv + [header]).decode()
+    return parse_defines(text)
+
+
+def verify_tokens(cc, header, impl, source, tokens, defines=()):
+    """True if `tokens` matches `cc -E` for `source` placed after the header."""
+    argv = ppbench.split_cc(cc) + ["-x", "c", "-E", "-P", "-"]
+    argv += ["-D" + d for d in defines]
+    if impl is not None:
+        argv.append("-D" + ppbench.IMPLS[impl])
+    text = '#include "%s"\n%s\n' % (header, source)
+    out = subprocess.run(argv, input=text.encode(), stdout=subprocess.PIPE,
+                         check=True).stdout.decode()
+    expected = [t.text for t in tokenize(out)]
+    got = [t.text for t in tokens]
+    # The header's own output (the TEST_VA_OPT main and so on) comes first.
+    return expected[len(expected) - len(got):] == got
@@ -0,0 +1,132 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Per-macro expansion profile of VA_* invocations.
+
+Expands each invocation given on the command line with the counting expander
+in ppexpand.py and reports, per macro, how often it was expanded, how many
+tokens were rescanned from its replacement list and how many were read while
+prescanning its arguments, plus the peak number of tokens waiting to be
+scanned. The test-suite macros (MAC0, EATER1, ARGS10, TEST_OVL...) are
+available to the invocations.
+
+    python3 bench/ppprof.py --impl c99 'VA_ISEMPTY(MAC0)' 'VA_NARGS(ARGS100)'
+
+With --check, every invocation the built-in test suite makes is expanded for
+each implementation and compared with `cc -E`, which is what makes the counts
+trustworthy.
+
+    python3 bench/ppprof.py --check
+"""
+
+import argparse
+import sys
+
+import ppbench
+import ppexpand
+
+# The test suite's invocations: (form, case lists it is used with).
+TEST_FORMS = [
+    ("VA_ISEMPTY(%s)", ["ISEMPTY_TEST_CASES"]),
+    ("VA_NOTEMPTY(%s)", ["ISEMPTY_TEST_CASES"]),
+    ("1 VA_OPT((%s), -1)", ["ISEMPTY_TEST_CASES"]),
+    ("0 VA_NOPT((%s), +1)", ["ISEMPTY_TEST_CASES"]),
+    ("VA_OPT_ELSE((%s), 0, 1)", ["ISEMPTY_TEST_CASES"]),
+    ("VA_IF_EMPTY_ELSE((%s), 1, 0)", ["ISEMPTY_TEST_CASES"]),
+    ("VA_WITH_EMPTINESS((%s), TEST_BIT_OPT, ~)", ["ISEMPTY_TEST_CASES"]),
+    ("VA_NARGS(%s)", ["SINGLE_TEST_CASES", "NARGS_TEST_CASES",
+                      "NARGS_LONG_TEST_CASES"]),
+    ("VA_OVERLOAD(TEST_OVL, %s)", ["SINGLE_TEST_CASES", "NARGS_TEST_CASES",
+                                   "VARIADIC_TEST_CASES"]),
+    ("0 VA_FOR_EACH(TEST_EACH_ONE, %s)", ["NARGS_TEST_CASES"]),
+    ("0 VA_FOR_EACH_I(TEST_EACH_IDX, %s)", ["NARGS_TEST_CASES"]),
+    ("VA_MAP(TEST_MAP_ONE, %s)", ["NARGS_TEST_CASES"]),
+]
+
+
+def profile(ex, source):
+    ex.reset()
+    out = ex.expand(ppexpand.tokenize(source))
+    rows = []
+    for name in sorted(ex.expansions,
+                       key=lambda n: (-ex.rescanned[n] - ex.prescanned[n], n)):
+        rows.append([name, ex.expansions[name], ex.rescanned[name],
+                     ex.prescanned[name]])
+    return out, rows
+
+
+def check(cc, impl, defines):
+    macros = ppexpand.load_macros(cc, ppbench.HEADER, impl, defines)
+    ex = ppexpand.Expander(macros)
+    sources = []
+    for form, lists in TEST_FORMS:
+        for name in lists:
+            for _, case in ppexpand.test_cases(macros, name):
+                sources.append(form % ppexpand.spell(case))
+    outputs = [ex.expand(ppexpand.tokenize(src)) for src in sources]
+    if ppexpand.verify_tokens(cc, ppbench.HEADER, impl, "\n".join(sources),
+                              sum(outputs, []), defines):
+        sys.stderr.write("%-6s %d invocations match cc -E\n"
+                         % (impl, len(sources)))
+        return True
+    for src, out in zip(sources, outputs):
+        if not ppexpand.verify_tokens(cc, ppbench.HEADER, impl, src, out,
+                                      defines):
+            sys.stderr.write("%-6s %s: expander gave %s\n"
+                             % (impl, src, ppexpand.spell(out)))
+    return False
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("invocations", nargs="*")
+    ap.add_argument("--cc", default=None, help="compiler driver (default $CC)")
+    ap.add_argument("--impl", default="c99", choices=sorted(ppbench.IMPLS))
+    ap.add_argument("--top", type=int, default=20,
+                    help="macros to show per invocation, 0 for all")
+    ap.add_argument("--check", action="store_true",
+                    help="compare the test suite's expansions with cc -E")
+    ap.add_argument("--out", default=None, help="also write all rows as CSV")
+    args = ap.parse_args()
+
+    sys.setrecursionlimit(100000)
+    defines = ["TEST_VA_OPT"]
+    if args.check:
+        ok = True
+        for impl in ppbench.DEFAULT_IMPLS:
+            ok = check(args.cc, impl, defines) and ok
+        if not ok:
+            return 1
+    if not args.invocations:
+        return 0
+    ex = ppexpand.Expander(ppexpand.load_macros(args.cc, ppbench.HEADER,
+                                                args.impl, defines))
+    csv_rows = []
+    for source in args.invocations:
+        out, rows = profile(ex, source)
+        if not ppexpand.verify_tokens(args.cc, ppbench.HEADER, args.impl,
+                                      source, out, defines):
+            sys.stderr.write("error: expander disagrees with cc -E on %s\n"
+                             % source)
+            return 1
+        print("%s -> %s" % (source, ppexpand.spell(out)))
+        print("  %d expansions, %d tokens scanned, peak %d tokens pending"
+              % (sum(ex.expansions.values()), ex.scanned, ex.peak))
+        print("  %-32s %10s %10s %10s" % ("macro", "expansions", "rescanned",
+                                          "prescanned"))
+        for row in rows[:args.top or len(rows)]:
+            print("  %-32s %10d %10d %10d" % tuple(row))
+        if args.top and len(rows) > args.top:
+            print("  ... %d more" % (len(rows) - args.top))
+        csv_rows += [[args.impl, source] + row + ["-"] for row in rows]
+        csv_rows.append([args.impl, source, "<total>",
+                         sum(ex.expansions.values()),
+                         sum(ex.rescanned.values()),
+                         sum(ex.prescanned.values()), ex.peak])
+    if args.out:
+        ppbench.write_csv(args.out, ["impl", "invocation", "macro",
+                                     "expansions", "rescanned", "prescanned",
+                                     "peak"], csv_rows)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,157 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Pin va_opt.h's implementation choice for a toolchain in va_opt_config.h.
+
+va_opt.h normally detects __VA_OPT__ support and walks its compiler chain in
+every translation unit. This script runs that detection once, on a probe
+preprocessed with the given compiler and flags, and writes the result to
+va_opt_config.h next to the header. When the header finds that file (through
+__has_include) it takes NTRNLVA_IMPL, VA_OPT_SUPPORTED and
+NTRNLVA_MSVC_TRADITIONAL from it and skips detection.
+
+Each toolchain gets its own entry, keyed on the compiler version and language
+mode macros, so one config file can serve several compilers or -std flags;
+configuring again for the same key replaces its entry. A compiler without an
+entry falls back to detection.
+
+With --check, the probe is preprocessed both with and without the config and
+the pinned values must match the detected ones.
+
+    python3 tools/configure.py --cc "gcc -std=c99" --check
+"""
+
+import argparse
+import os
+import re
+import shlex
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+HEADER = os.path.join(ROOT, "va_opt.h")
+CONFIG = os.path.join(ROOT, "va_opt_config.h")
+
+# What identifies a toolchain and language mode for an entry.
+KEYS = ["__clang_major__", "__clang_minor__", "__GNUC__", "__GNUC_MINOR__",
+        "__GNUC_PATCHLEVEL__", "__INTEL_COMPILER", "__INTEL_LLVM_COMPILER",
+        "__TINYC__", "_MSC_VER", "_MSVC_TRADITIONAL", "__llvm__",
+        "__STRICT_ANSI__", "__STDC_VERSION__", "__cplusplus"]
+
+# What the header decides; printed by the probe.
+RESULTS = ["NTRNLVA_IMPL", "VA_OPT_SUPPORTED", "NTRNLVA_MSVC_TRADITIONAL",
+           "NTRNLVA_CONFIGURED"]
+
+IMPL_NAMES = {"1": "native", "2": "gnu", "3": "msvc", "4": "c99"}
+
+_ENTRY = re.compile(r"^/\* ([^\n]*) \*/\n#if ([^\n]*)\n.*?^#endif\n",
+                    re.S | re.M)
+
+
+def split_cc(cc):
+    return shlex.split(cc or os.environ.get("CC") or "cc")
+
+
+def probe_source(use_config):
+    lines = [] if use_config else ["#define VA_OPT_NO_CONFIG"]
+    lines.append('#include "va_opt.h"')
+    for name in KEYS + RESULTS:
+        lines += ["#ifdef " + name, '@ "%s" = %s ;' % (name, name), "#endif"]
+    return "\n".join(lines) + "\n"
+
+
+def probe(cc, use_config):
+    """Map macro name -> value for the keys and results the probe sees."""
+    argv = split_cc(cc) + ["-E", "-P", "-I", ROOT, "-"]
+    if "-x" not in argv:
+        argv[1:1] = ["-x", "c"]
+    out = subprocess.run(argv, input=probe_source(use_config).encode(),
+                         stdout=subprocess.PIPE, check=True).stdout.decode()
+    return {m.group(1): m.group(2).strip()
+            for m in re.finditer(r'@ "(\w+)" = ([^;]*);', out)}
+
+
+def condition(values):
+    parts = []
+    for name in KEYS:
+        if name not in values:
+            parts.append("!defined(%s)" % name)
+        elif values[name]:
+            parts.append("%s == %s" % (name, values[name]))
+        else:
+            parts.append("defined(%s)" % name)
+    return " && ".join(parts)
+
+
+def entry(cc, values):
+    cond = condition(values)
+    lines = ["/* %s */" % " ".join(split_cc(cc)).replace("*/", "* /"),
+             "#if !defined(NTRNLVA_CONFIGURED) && %s" % cond,
+             "    #define NTRNLVA_CONFIGURED 1",
+             "    #define NTRNLVA_IMPL %s" % values["NTRNLVA_IMPL"]]
+    if "VA_OPT_SUPPORTED" in values:
+        lines += ["    #ifndef VA_OPT_SUPPORTED",
+                  "        #define VA_OPT_SUPPORTED %s"
+                  % values["VA_OPT_SUPPORTED"],
+                  "    #endif"]
+    lines += ["    #define NTRNLVA_MSVC_TRADITIONAL %s"
+              % values["NTRNLVA_MSVC_TRADITIONAL"],
+              "#endif", ""]
+    return "\n".join(lines)
+
+
+def write_config(path, cc, values):
+    entries = []
+    if os.path.exists(path):
+        with open(path) as f:
+            entries = [m.group(0) for m in _ENTRY.finditer(f.read())]
+    new = entry(cc, values)
+    cond = _ENTRY.match(new).group(2)
+    entries = [e for e in entries if _ENTRY.match(e).group(2) != cond]
+    entries.append(new)
+    with open(path, "w") as f:
+        f.write("/* SPDX-License-Identifier: CC0-1.0 */\n\n"
+                "/* Generated by tools/configure.py; one entry per toolchain "
+                "and language mode.\nDelete this file to go back to detecting "
+                "the implementation in every\ntranslation unit. */\n\n")
+        f.write("\n".join(entries))
+
+
+def check(cc):
+    detected = probe(cc, False)
+    pinned = probe(cc, True)
+    if "NTRNLVA_CONFIGURED" not in pinned:
+        sys.stderr.write("va_opt_config.h has no entry for %s\n"
+                         % " ".join(split_cc(cc)))
+        return False
+    ok = True
+    for name in RESULTS[:-1]:
+        if detected.get(name) != pinned.get(name):
+            sys.stderr.write("%s: detected %s, pinned %s\n"
+                             % (name, detected.get(name), pinned.get(name)))
+            ok = False
+    return ok
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None,
+                    help="compiler driver and flags (default $CC)")
+    ap.add_argument("--out", default=CONFIG)
+    ap.add_argument("--check", action="store_true",
+                    help="verify the pinned values against detection")
+    args = ap.parse_args()
+
+    if os.path.abspath(args.out) != CONFIG and args.check:
+        ap.error("--check reads the config next to va_opt.h, drop --out")
+    values = probe(args.cc, False)
+    write_config(args.out, args.cc, values)
+    sys.stderr.write("%s: %s implementation for %s\n"
+                     % (os.path.relpath(args.out),
+                        IMPL_NAMES.get(values["NTRNLVA_IMPL"], "?"),
+                        " ".join(split_cc(args.cc))))
+    if args.check and not check(args.cc):
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,194 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Diff the `cc -E` output of the VA_* macros across implementations.
+
+A corpus TU applies every public macro to each case of the built-in test
+suite's argument lists, once after a space and once glued to the previous
+token. It is preprocessed once per VA_OPT_USE_* setting, and the output after
+the header (line markers included) is compared with the native
+implementation's, byte for byte. A second TU, without the test suite, applies
+the macros to a few plain payloads and is compared whole, header lines and
+all, as a compiler cache would see it.
+
+A third TU applies VA_OPT, VA_NOPT and VA_OPT_ELSE to every pairing of an
+argument list and a payload from ARGS and PAYLOADS below: strings, nested
+parentheses, stray commas, `#` and function-like macro names, which the test
+suite's 0/1 checks do not cover. Each line is labelled with its invocation in
+a string literal, so a diff shows what was expanded.
+
+With --canonical, VA_OPT_CANONICAL is defined and any difference is an error.
+With --normalize, each line is split into tokens and respelled with single
+spaces before comparing, and any difference is an error; the token stream has
+to match even where whitespace does not. With neither, the differences are
+only listed. The implementations are preprocessed in parallel.
+
+    python3 tools/diff_impls.py --canonical
+    python3 tools/diff_impls.py --normalize --corpus payload
+"""
+
+import argparse
+import concurrent.futures
+import difflib
+import os
+import re
+import shlex
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+IMPLS = {
+    "native": "VA_OPT_USE_NATIVE",
+    "gnu": "VA_OPT_USE_GNU",
+    "c99": "VA_OPT_USE_C99",
+}
+
+# Invocation over __VA_ARGS__ -> case lists it is applied to
+FORMS = [
+    ("VA_ISEMPTY(__VA_ARGS__)", ["ISEMPTY_TEST_CASES"]),
+    ("VA_NOTEMPTY(__VA_ARGS__)", ["ISEMPTY_TEST_CASES"]),
+    ("VA_OPT((__VA_ARGS__), x, y)", ["ISEMPTY_TEST_CASES"]),
+    ("VA_NOPT((__VA_ARGS__), x, y)", ["ISEMPTY_TEST_CASES"]),
+    ("VA_OPT_ELSE((__VA_ARGS__), t, e, f)", ["ISEMPTY_TEST_CASES"]),
+    ("VA_IF_EMPTY_ELSE((__VA_ARGS__), t, e, f)", ["ISEMPTY_TEST_CASES"]),
+    ("VA_WITH_EMPTINESS((__VA_ARGS__), TEST_BIT_OPT, ~)",
+     ["ISEMPTY_TEST_CASES"]),
+    ("VA_NARGS(__VA_ARGS__)", ["ISEMPTY_TEST_CASES", "NARGS_TEST_CASES"]),
+    ("VA_OVERLOAD(TEST_OVL, __VA_ARGS__)",
+     ["ISEMPTY_TEST_CASES", "NARGS_TEST_CASES"]),
+    ("VA_FOR_EACH(TEST_EACH_ONE, __VA_ARGS__)", ["NARGS_TEST_CASES"]),
+    ("VA_FOR_EACH_I(TEST_EACH_IDX, __VA_ARGS__)", ["NARGS_TEST_CASES"]),
+    ("VA_MAP(TEST_MAP_ONE, __VA_ARGS__)", ["NARGS_TEST_CASES"]),
+]
+
+
+# Argument lists tested for emptiness by the payload corpus
+ARGS = ["", "/**/", "a", "a, b", ",", ", ,", "()", "(a, b)", "f(x)", "MAC0",
+        "MACV", "EATER1", "MAC0 ()", "\"s, t\"", "'('", "1.5e+3", "#",
+        "ARGS10", "MACMANYPLUS"]
+
+# What VA_OPT, VA_NOPT and VA_OPT_ELSE produce for them
+PAYLOADS = ["x", "", "x, y", "(x)", "f(a, b)", "\"str\"", "MAC0()", "# x",
+            ", ,", "VA_OPT((a), nested)", "VA_NOPT((), nested)",
+            "-1.0e-3 >>= 'c'"]
+
+PAYLOAD_FORMS = ["VA_OPT((%s), %s)", "VA_NOPT((%s), %s)",
+                 "VA_OPT_ELSE((%s), %s, e)", "VA_OPT_ELSE((%s), t, %s)"]
+
+_TOKEN = re.compile(r"""\s*(L?"(?:\\.|[^"\\])*"|L?'(?:\\.|[^'\\])*'"""
+                    r"|\.?\d(?:[eEpP][+-]|[\w.])*|\w+"
+                    r"|%:%:|\.\.\.|<<=|>>=|->|\+\+|--|<<|>>|<=|>=|==|!=|&&"
+                    r"|\|\||[-+*/%&|^]=|##|<:|:>|<%|%>|%:|\S)")
+
+
+def normalize(line):
+    """One space between tokens, none elsewhere."""
+    return " ".join(_TOKEN.findall(line))
+
+
+def split_cc(cc):
+    return shlex.split(cc or os.environ.get("CC") or "cc")
+
+
+def corpus():
+    lines = ["#define TEST_VA_OPT", '#include "va_opt.h"', "#undef X"]
+    for form, lists in FORMS:
+        lines.append("#define X(expected, ...) [ %s] [%s]" % (form, form))
+        lines += lists
+        lines.append("#undef X")
+    return "\n".join(lines) + "\n"
+
+
+PLAIN_CASES = ["", "a", "a, b", "()", "f()", "(a, b) c"]
+
+
+def plain_corpus():
+    lines = ['#include "va_opt.h"']
+    for form, _ in FORMS:
+        if "TEST_" in form:
+            continue
+        lines.append(" ".join("[%s]" % form.replace("__VA_ARGS__", case)
+                              for case in PLAIN_CASES))
+    return "\n".join(lines) + "\n"
+
+
+def payload_corpus():
+    lines = ["#define TEST_VA_OPT", '#include "va_opt.h"']
+    for form in PAYLOAD_FORMS:
+        for args in ARGS:
+            for payload in PAYLOADS:
+                call = form % (args, payload)
+                label = call.replace("\\", "\\\\").replace('"', '\\"')
+                lines.append('"%s": [%s]' % (label, call))
+    return "\n".join(lines) + "\n"
+
+
+CORPORA = {
+    "test": (corpus, False),
+    "plain": (plain_corpus, True),
+    "payload": (payload_corpus, False),
+}
+
+
+def preprocess(cc, path, impl, defines, whole=False):
+    argv = split_cc(cc) + ["-E", "-I", ROOT, "-D" + IMPLS[impl]]
+    argv += ["-D" + d for d in defines] + [path]
+    out = subprocess.check_output(argv).decode()
+    if whole:
+        return out
+    # Keep what follows the return from va_opt.h to the corpus file.
+    marker = re.compile(r'^# \d+ "%s" 2$' % re.escape(path), re.M)
+    ends = list(marker.finditer(out))
+    return out[ends[-1].start():] if ends else out
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None, help="compiler driver (default $CC)")
+    ap.add_argument("--impls", nargs="+", default=list(IMPLS),
+                    choices=list(IMPLS))
+    ap.add_argument("--canonical", action="store_true",
+                    help="define VA_OPT_CANONICAL and fail on any difference")
+    ap.add_argument("--normalize", action="store_true",
+                    help="compare tokens only and fail on any difference")
+    ap.add_argument("--corpus", nargs="+", default=list(CORPORA),
+                    choices=list(CORPORA))
+    ap.add_argument("--jobs", type=int, default=os.cpu_count() or 1,
+                    help="preprocessor runs at a time")
+    args = ap.parse_args()
+
+    defines = ["VA_OPT_CANONICAL"] if args.canonical else []
+    differ = 0
+    pool = concurrent.futures.ThreadPoolExecutor(max(1, args.jobs))
+    for name in args.corpus:
+        make, whole = CORPORA[name]
+        with tempfile.NamedTemporaryFile("w", suffix=".c", dir=ROOT,
+                                         prefix=".diff_") as f:
+            f.write(make())
+            f.flush()
+            jobs = dict((impl, pool.submit(preprocess, args.cc, f.name, impl,
+                                           defines, whole))
+                        for impl in args.impls)
+            outputs = dict((impl, job.result().splitlines())
+                           for impl, job in jobs.items())
+        if args.normalize:
+            outputs = dict((impl, [normalize(l) for l in lines])
+                           for impl, lines in outputs.items())
+        ref = args.impls[0]
+        for impl in args.impls[1:]:
+            diff = list(difflib.unified_diff(
+                outputs[ref], outputs[impl], ref, impl, n=0, lineterm=""))
+            changed = len([d for d in diff if d.startswith("-")
+                           and not d.startswith("---")])
+            sys.stderr.write("%s, %s vs %s: %d of %d lines differ\n"
+                             % (name, ref, impl, changed,
+                                len(outputs[ref])))
+            if changed:
+                differ += 1
+                sys.stdout.write("\n".join(diff[:40]) + "\n")
+    pool.shutdown()
+    return 1 if differ and (args.canonical or args.normalize) else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
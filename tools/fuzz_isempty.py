@@ -0,0 +1,268 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Fuzz VA_ISEMPTY and VA_OPT of the GNU and C99 paths against native.
+
+Random argument lists are built from identifiers, numbers, punctuators,
+string and character literals, commas, comments, nested parentheses and the
+test suite's function-like macros (MAC0, MACV, EATER0..5, MACMANYPLUS...).
+Each batch goes into one TU as lines of
+
+    @N: VA_ISEMPTY(args) | VA_OPT((args), x) @@ args @@ FUZZ_RESCAN(args)
+
+which is preprocessed once per implementation, in parallel. The native
+`__VA_OPT__` implementation is the oracle. A line that native cannot
+preprocess, such as MAC0 called with an argument, is dropped. Where another
+implementation gives different tokens or an error, the list is minimized by
+removing items and unwrapping parentheses for as long as the mismatch stays,
+and the minimal case is reported.
+
+The C99 path has limitations that are not reported. MAC2 is never generated,
+since a first argument naming a macro with two or more parameters does not
+compile. The two echoes after `@@` show the list expanded once and expanded
+again. Where they differ, as for `EATER0 EATER2 ()`, the C99 probes see the
+second expansion while `__VA_OPT__` sees the first. Where the first has an
+empty first argument followed by one that starts with three parenthesized
+groups, the rest of the list looks like the end-of-list sentinel `()()()`.
+
+    python3 tools/fuzz_isempty.py --cases 20000 --seed 1
+"""
+
+import argparse
+import concurrent.futures
+import os
+import random
+import re
+import subprocess
+import sys
+import tempfile
+
+import diff_impls
+
+ROOT = diff_impls.ROOT
+
+PROBES = ["VA_ISEMPTY(%s)", "VA_OPT((%s), x)"]
+
+IDENTS = ["a", "b", "x", "int", "_", "L"]
+NUMBERS = ["0", "1", "0x1f", "1.5e+3", ".5", "1u"]
+PUNCTS = ["+", "-", "*", "/", "%", "!", "~", "<", ">", "=", "&", "|", "^",
+          "?", ":", ";", ".", "->", "++", "--", "<<", ">>=", "==", "&&",
+          "...", "[", "]", "{", "}", "#", "##", "%:", "<:"]
+LITERALS = ['""', '"s"', '"a, b"', '"("', '")"', "'('", "','", "'\\''",
+            'L"w"']
+COMMENTS = ["/**/", "/* , ( */"]
+MACROS = ["MAC0", "MAC1", "MACV", "EATER0", "EATER1", "EATER2", "EATER3",
+          "EATER4", "EATER5", "MACMANYPLUS", "ARGS10", "VA_ISEMPTY",
+          "VA_NARGS"]
+
+# (kind, weight)
+KINDS = [("ident", 3), ("number", 1), ("punct", 3), ("literal", 2),
+         ("comment", 1), ("comma", 3), ("group", 3), ("macro", 4)]
+
+
+def gen_items(rng, depth):
+    items = []
+    for _ in range(rng.choice([0, 0, 1, 1, 2, 3, 4, 6])):
+        kind = rng.choices([k for k, _ in KINDS],
+                           [w for _, w in KINDS])[0]
+        if kind == "group" and depth >= 3:
+            kind = "ident"
+        if kind == "ident":
+            items.append(rng.choice(IDENTS))
+        elif kind == "number":
+            items.append(rng.choice(NUMBERS))
+        elif kind == "punct":
+            items.append(rng.choice(PUNCTS))
+        elif kind == "literal":
+            items.append(rng.choice(LITERALS))
+        elif kind == "comment":
+            items.append(rng.choice(COMMENTS))
+        elif kind == "comma":
+            items.append(",")
+        elif kind == "group":
+            items.append(gen_items(rng, depth + 1))
+        else:
+            items.append(rng.choice(MACROS))
+            if rng.random() < 0.5:
+                items.append(gen_items(rng, depth + 1))
+    return items
+
+
+def spell(items):
+    """Source text of an item list; sublists are parenthesized groups."""
+    out = []
+    for item in items:
+        if isinstance(item, list):
+            out.append("(" + spell(item) + ")")
+        else:
+            out.append(item)
+    return " ".join(out)
+
+
+def reductions(items):
+    """Every item list one removal or one unwrapping away from `items`."""
+    for i, item in enumerate(items):
+        yield items[:i] + items[i + 1:]
+        if isinstance(item, list):
+            yield items[:i] + item + items[i + 1:]
+            for sub in reductions(item):
+                yield items[:i] + [sub] + items[i + 1:]
+
+
+def groups(tokens):
+    """How many parenthesized groups `tokens` starts with."""
+    count = depth = 0
+    for tok in tokens:
+        if depth == 0 and tok != "(":
+            break
+        depth += {"(": 1, ")": -1}.get(tok, 0)
+        count += depth == 0
+    return count
+
+
+def c99_limits(echo):
+    """Whether the list is expanded differently by a rescan, or has an
+    empty first argument followed by one that looks like
+    NTRNLVA_SENTINEL_."""
+    once, _, twice = echo.partition(" @ @ ")
+    if once != twice:
+        return True
+    args, depth, current = [], 0, []
+    for tok in once.split():
+        if tok == "," and depth == 0:
+            args.append(current)
+            current = []
+            continue
+        depth += {"(": 1, ")": -1}.get(tok, 0)
+        current.append(tok)
+    args.append(current)
+    return len(args) > 1 and not args[0] and groups(args[1]) >= 3
+
+
+# Implementation -> cases it is known to get wrong, given native's echoes
+KNOWN = {"c99": c99_limits}
+
+
+def make_tu(cases):
+    lines = ["#define TEST_VA_OPT", '#include "va_opt.h"',
+             "#define FUZZ_RESCAN(...) __VA_ARGS__"]
+    for i, case in enumerate(cases):
+        text = spell(case)
+        lines.append("@%d: %s @@ %s @@ FUZZ_RESCAN(%s)"
+                     % (i, " | ".join(p % text for p in PROBES), text, text))
+    return lines
+
+
+def run(cc, impl, path, first):
+    """Map case index -> normalized output, or None where cc reported an
+    error on that case's line."""
+    argv = diff_impls.split_cc(cc) + ["-E", "-P", "-I", ROOT,
+                                      "-D" + diff_impls.IMPLS[impl], path]
+    proc = subprocess.run(argv, stdout=subprocess.PIPE,
+                          stderr=subprocess.PIPE)
+    bad = set(int(m.group(1)) - first for m in re.finditer(
+        r"^%s:(\d+):\d+: error" % re.escape(path),
+        proc.stderr.decode(errors="replace"), re.M))
+    found = {}
+    for m in re.finditer(r"^@ ?(\d+) ?:(.*)$", proc.stdout.decode(), re.M):
+        i = int(m.group(1))
+        found[i] = None if i in bad else diff_impls.normalize(m.group(2))
+    for i in bad:
+        found[i] = None
+    return found
+
+
+def evaluate(cc, impls, cases, pool):
+    """Map impl -> {case index: output} for one batch."""
+    lines = make_tu(cases)
+    with tempfile.NamedTemporaryFile("w", suffix=".c", dir=ROOT,
+                                     prefix=".fuzz_") as f:
+        f.write("\n".join(lines) + "\n")
+        f.flush()
+        first = len(lines) - len(cases) + 1
+        jobs = dict((impl, pool.submit(run, cc, impl, f.name, first))
+                    for impl in ["native"] + impls)
+        return dict((impl, job.result()) for impl, job in jobs.items())
+
+
+def mismatches(results, impls, count):
+    """(case index, impl) pairs where impl disagrees with a valid native,
+    and the number of disagreements put down to known limitations."""
+    out = []
+    known = 0
+    for i in range(count):
+        want = results["native"].get(i)
+        if want is None:
+            continue
+        want, _, echo = want.partition(" @ @ ")
+        for impl in impls:
+            got = (results[impl].get(i) or "").partition(" @ @ ")[0]
+            if got == want:
+                continue
+            if impl in KNOWN and KNOWN[impl](echo):
+                known += 1
+            else:
+                out.append((i, impl))
+    return out, known
+
+
+def minimize(cc, impl, items, pool):
+    """Shrink a failing item list while native and impl still disagree."""
+    while True:
+        candidates = list(reductions(items))
+        if not candidates:
+            return items
+        results = evaluate(cc, [impl], candidates, pool)
+        failing = [i for i, _ in mismatches(results, [impl],
+                                            len(candidates))[0]]
+        if not failing:
+            return items
+        items = min((candidates[i] for i in failing),
+                    key=lambda c: len(spell(c)))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None, help="compiler driver (default $CC)")
+    ap.add_argument("--impls", nargs="+", default=["gnu", "c99"],
+                    choices=[i for i in diff_impls.IMPLS if i != "native"])
+    ap.add_argument("--cases", type=int, default=5000)
+    ap.add_argument("--batch", type=int, default=1000,
+                    help="cases per preprocessed TU")
+    ap.add_argument("--seed", type=int, default=None,
+                    help="random seed (default: picked and printed)")
+    ap.add_argument("--jobs", type=int, default=os.cpu_count() or 1,
+                    help="preprocessor runs at a time")
+    args = ap.parse_args()
+
+    seed = args.seed
+    if seed is None:
+        seed = random.SystemRandom().randrange(1 << 32)
+    rng = random.Random(seed)
+    pool = concurrent.futures.ThreadPoolExecutor(max(1, args.jobs))
+    tested = skipped = known = 0
+    failures = {}
+    while tested + skipped < args.cases:
+        cases = [gen_items(rng, 0) for _ in
+                 range(min(args.batch, args.cases - tested - skipped))]
+        results = evaluate(args.cc, args.impls, cases, pool)
+        valid = sum(1 for i in range(len(cases))
+                    if results["native"].get(i) is not None)
+        tested += valid
+        skipped += len(cases) - valid
+        bad, limits = mismatches(results, args.impls, len(cases))
+        known += limits
+        for i, impl in bad:
+            small = spell(minimize(args.cc, impl, cases[i], pool))
+            if (impl, small) not in failures:
+                failures[impl, small] = spell(cases[i])
+    pool.shutdown()
+    sys.stderr.write("seed %d: %d cases, %d rejected by native, %d known "
+                     "limitations, %d distinct failures\n"
+                     % (seed, tested, skipped, known, len(failures)))
+    for (impl, small), original in sorted(failures.items()):
+        print("%s: VA_ISEMPTY(%s)" % (impl, small))
+        print("    found as: %s" % original)
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
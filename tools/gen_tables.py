@@ -0,0 +1,180 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Regenerate the repetitive macro tables in va_opt.h.
+
+Each table sits between a pair of markers in the header, indented like the
+block around them:
+
+    /* BEGIN GENERATED BY tools/gen_tables.py: <name> */
+    ...
+    /* END GENERATED: <name> */
+
+and is rewritten from the functions below, so a change to a table's shape
+is made here once instead of on every line. With --check nothing is written
+and the exit status says whether the header is up to date.
+
+    python3 tools/gen_tables.py            # rewrite va_opt.h
+    python3 tools/gen_tables.py --check    # fail if va_opt.h is stale
+"""
+
+import argparse
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+HEADER = os.path.join(ROOT, "va_opt.h")
+WIDTH = 80
+
+# VA_FOR_EACH: elements per chunk step, and the chunks each
+# VA_OPT_MAX_EACH block adds (its limit, the last chunk it defines).
+EACH_CHUNK = 10
+EACH_BLOCKS = [(0, 2), (32, 5), (64, 8), (96, 11)]
+
+# VA_NARGS: arguments per chunk, and chunks the NTRNLVA_NARGS_L8 chain strips.
+NARGS_CHUNK = 64
+NARGS_CHUNKS = 256
+
+
+def define(head, body, indent, own_line=False):
+    """A #define wrapped at WIDTH, with the backslashes in the last column.
+    head and body are lists of pieces that are never split; the body starts
+    on its own line if the head wraps or own_line is set."""
+    lead = " " * indent + "#define "
+    lines = []
+    line = lead + head[0]
+    align = " " * (len(lead) + head[0].find("(") + 1)
+    for piece in head[1:]:
+        if len(line) + 1 + len(piece) > WIDTH - 2:
+            lines.append(line)
+            line = align + piece
+        else:
+            line += " " + piece
+    wrapped = own_line or bool(lines)
+    for piece in body:
+        if wrapped or len(line) + 1 + len(piece) > WIDTH - 2:
+            wrapped = False
+            lines.append(line)
+            line = " " * (indent + 2) + piece
+        else:
+            line += " " + piece
+    lines.append(line)
+    return "\n".join([l.ljust(WIDTH - 1) + "\\" for l in lines[:-1]] +
+                     [lines[-1]])
+
+
+def each_chunk(n, indent):
+    """NTRNLVA_EACH_C<n>: ten elements with literal indices, then the next
+    chunk or the tail, chosen by NTRNLVA_EACH_NEXT."""
+    xs = ["x%d" % i for i in range(EACH_CHUNK)]
+    head = ["NTRNLVA_EACH_C%d(z," % n, "s,", "c,", "m,", "k,"] + \
+        [x + "," for x in xs] + ["...)"]
+    body = []
+    for i, x in enumerate(xs):
+        body.append("%s()c(m, %d, %s)" % ("z" if i == 0 else "s",
+                                          n * EACH_CHUNK + i, x))
+    body.append("NTRNLVA_EACH_GO(NTRNLVA_EACH_NEXT(%d, __VA_ARGS__)" % (n + 1))
+    body.append("(s, s, c, m, %d, __VA_ARGS__))" % (n + 1))
+    return define(head, body, indent)
+
+
+def each_tail(t):
+    """NTRNLVA_EACH_F<t>: the last t elements, indexed k0 to k<t-1>."""
+    xs = ["x%d" % i for i in range(t)]
+    head = ["NTRNLVA_EACH_F%d(z," % t, "s,", "c,", "m,", "k,"] + \
+        [x + "," for x in xs] + ["...)"]
+    body = ["%s()c(m, k##%d, %s)" % ("z" if i == 0 else "s", i, x)
+            for i, x in enumerate(xs)]
+    return define(head, body, 0)
+
+
+def each_lookup():
+    """NTRNLVA_EACH_SEL<k+1>_I picks the argument after the first k of the
+    list and NTRNLVA_EACH_TABLE_: a tail NTRNLVA_EACH_F<t> when only t
+    elements and the trailing empty argument are left, else an element."""
+    k = EACH_CHUNK + 1
+    head = ["NTRNLVA_EACH_SEL%d_I(_1," % k] + \
+        ["_%d," % i for i in range(2, k)] + ["t,", "...)"]
+    out = [define(head, ["t"], 0)]
+    table = ["()()(NTRNLVA_EACH_F%d)," % t
+             for t in range(EACH_CHUNK - 1, -1, -1)] + ["~"]
+    out.append(define(["NTRNLVA_EACH_TABLE_"], table, 0, True))
+    return out
+
+
+def each():
+    out = each_lookup()
+    for t in range(EACH_CHUNK):
+        out.append(each_tail(t))
+    first = 0
+    for limit, last in EACH_BLOCKS:
+        indent = 4 if limit else 0
+        if limit:
+            out.append("#if VA_OPT_MAX_EACH > %d" % limit)
+        for n in range(first, last + 1):
+            out.append(" " * indent + "#define NTRNLVA_EACH_HAS_C%d ()" % n)
+            out.append(each_chunk(n, indent))
+        if limit:
+            out.append("#endif")
+        first = last + 1
+    return "\n".join(out)
+
+
+def nargs_add64():
+    """VA_OPT_MINIMAL_OUTPUT's running total: NTRNLVA_NARGS_ADD64_<acc> is
+    acc plus one chunk, with an empty acc standing for 0."""
+    out = []
+    for k in range(NARGS_CHUNKS):
+        out.append("    #define NTRNLVA_NARGS_ADD64_%s %d"
+                   % (k * NARGS_CHUNK if k else "", (k + 1) * NARGS_CHUNK))
+    return "\n".join(out)
+
+
+TABLES = {
+    "each": each,
+    "nargs_add64": nargs_add64,
+}
+
+_REGION = re.compile(
+    r"(/\* BEGIN GENERATED BY tools/gen_tables\.py: (\w+) \*/\n)"
+    r"(.*?)"
+    r"(^[ \t]*/\* END GENERATED: \2 \*/)", re.S | re.M)
+
+
+def regenerate(source):
+    seen = set()
+
+    def replace(m):
+        seen.add(m.group(2))
+        return m.group(1) + TABLES[m.group(2)]() + "\n" + m.group(4)
+
+    result = _REGION.sub(replace, source)
+    missing = sorted(set(TABLES) - seen)
+    if missing:
+        raise SystemExit("va_opt.h has no region for: %s" % ", ".join(missing))
+    return result
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--check", action="store_true",
+                    help="exit 1 if va_opt.h differs from the generated tables")
+    args = ap.parse_args()
+
+    with open(HEADER) as f:
+        source = f.read()
+    result = regenerate(source)
+    if args.check:
+        if result != source:
+            sys.stderr.write("va_opt.h: generated tables are stale, run "
+                             "python3 tools/gen_tables.py\n")
+            return 1
+        sys.stderr.write("va_opt.h: generated tables are up to date\n")
+        return 0
+    if result != source:
+        with open(HEADER, "w") as f:
+            f.write(result)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
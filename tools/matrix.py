@@ -0,0 +1,406 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Run the test.yaml compiler matrix with the compilers installed locally.
+
+This is an offline counterpart to `make test_godbolt`. It reads the same
+test.yaml and runs each compiler x variant cell of its `tests:` section: the
+variant's prepend lines and the header are compiled and the test binary run.
+Cells run concurrently. A compiler from test.yaml is used when its nickname
+maps to a command on PATH (see LOCAL, or add --compiler nick=command). Entries
+marked local_compile are only used to preprocess, as on godbolt, and the
+result is built with --host-cc.
+
+Results are cached in .matrix_cache/, keyed by the hash of va_opt.h (and
+va_opt_config.h, if present), the cell's flags and lines, and the compiler's
+version banner, so rerunning after an unrelated change is instant.
+
+With --readme, the rows of the README compatibility matrix for the compilers
+run here are rewritten, or appended with a dagger mark. Rows measured on
+godbolt are left alone.
+
+    python3 tools/matrix.py --readme
+    python3 tools/matrix.py --compiler gcc3=gcc-3.4 clang=clang-18
+"""
+
+import argparse
+import concurrent.futures
+import hashlib
+import json
+import os
+import re
+import shlex
+import shutil
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+YAML = os.path.join(ROOT, "test.yaml")
+README = os.path.join(ROOT, "README.md")
+CACHE = os.path.join(ROOT, ".matrix_cache")
+
+# test.yaml nickname -> local command
+LOCAL = {
+    "gcc": "gcc",
+    "gcc99": "gcc",
+    "clang": "clang",
+    "msvcc": "cl",
+    "msvc": "cl",
+    "nvc": "nvc",
+    "icc": "icc",
+    "compcert": "ccomp",
+    "tcc": "tcc",
+    "sdcc": "sdcc",
+}
+
+FAILED, BROKEN, PASSED, WARNED, AUTO = "❌", "⚠️", "✅", "ℹ️", "⭐"
+
+LOCAL_MARK = "†"
+LOCAL_NOTE = ("%s This compiler was run locally by `make matrix`."
+              % LOCAL_MARK)
+
+
+def _scalar(text):
+    text = text.strip()
+    if text[:1] in "\"'":
+        return text[1:-1]
+    if text in ("true", "false"):
+        return text == "true"
+    if re.match(r"^-?\d+$", text):
+        return int(text)
+    return text
+
+
+def _value(text):
+    if text.startswith("["):
+        inner = text.strip()[1:-1]
+        return [_scalar(v) for v in re.findall(
+            r"\"[^\"]*\"|'[^']*'|[^,\s][^,]*", inner)]
+    return _scalar(text)
+
+
+def parse_yaml(text):
+    """The block mappings and sequences test.yaml uses, for machines without
+    PyYAML."""
+    lines = []
+    for raw in text.splitlines():
+        stripped = raw.split(" #")[0].rstrip()
+        if stripped.strip() and not stripped.strip().startswith("#"):
+            lines.append((len(stripped) - len(stripped.lstrip()),
+                          stripped.strip()))
+
+    def block(i, indent):
+        if lines[i][1].startswith("- "):
+            out = []
+            while i < len(lines) and lines[i][0] == indent and \
+                    lines[i][1].startswith("- "):
+                item = lines[i][1][2:]
+                if ":" in item and not item.startswith(("\"", "'")):
+                    # A mapping whose first key shares the dash's line
+                    lines[i] = (indent + 2, item)
+                    value, i = block(i, indent + 2)
+                else:
+                    value, i = _scalar(item), i + 1
+                out.append(value)
+            return out, i
+        out = {}
+        while i < len(lines) and lines[i][0] == indent:
+            key, _, rest = lines[i][1].partition(":")
+            if rest.strip():
+                out[key] = _value(rest.strip())
+                i += 1
+            elif i + 1 < len(lines) and lines[i + 1][0] >= indent and \
+                    (lines[i + 1][0] > indent or
+                     lines[i + 1][1].startswith("- ")):
+                out[key], i = block(i + 1, lines[i + 1][0])
+            else:
+                out[key] = None
+                i += 1
+        return out, i
+
+    return block(0, lines[0][0])[0] if lines else {}
+
+
+def load_yaml(path):
+    with open(path) as f:
+        text = f.read()
+    try:
+        import yaml
+    except ImportError:
+        return parse_yaml(text)
+    return yaml.safe_load(text)
+
+
+def flags_of(entry):
+    out = []
+    for flag in entry.get("extra_flags") or []:
+        out += shlex.split(flag)
+    return out
+
+
+def is_msvc(argv):
+    return os.path.basename(argv[0]).lower() in ("cl", "cl.exe")
+
+
+def banner(argv):
+    """First line the compiler prints about its version."""
+    for flag in (["--version"], ["-v"], []):
+        try:
+            proc = subprocess.run(argv + flag, stdout=subprocess.PIPE,
+                                  stderr=subprocess.STDOUT, timeout=30)
+        except (OSError, subprocess.TimeoutExpired):
+            continue
+        text = proc.stdout.decode(errors="replace").strip()
+        if re.search(r"\d+\.\d+", text):
+            return text.splitlines()[0] if flag else text
+    return ""
+
+
+def row_name(compiler, version):
+    """The display name with the local version in place of godbolt's."""
+    name = compiler["display_name"]
+    found = re.search(r"\d+(\.\d+)+", version)
+    if found:
+        name = re.sub(r"\d+(\.\d+)+", found.group(0), name, count=1)
+    return name + LOCAL_MARK
+
+
+def cell_source(test, variant):
+    lines = list(test.get("prepend_lines") or [])
+    lines += variant.get("prepend_lines") or []
+    lines.append('#include "%s"' % test["file_name"])
+    return "\n".join(lines) + "\n"
+
+
+def run(argv, **kw):
+    """Exit status, stdout and stderr."""
+    try:
+        proc = subprocess.run(argv, stdout=subprocess.PIPE,
+                              stderr=subprocess.PIPE, timeout=300, **kw)
+    except subprocess.TimeoutExpired:
+        return 1, "", "timed out"
+    return (proc.returncode, proc.stdout.decode(errors="replace"),
+            proc.stderr.decode(errors="replace"))
+
+
+def compile_cmd(argv, flags, src, exe):
+    if is_msvc(argv):
+        return argv + ["/nologo"] + flags + ["/I", ROOT, src, "/Fe" + exe]
+    return argv + flags + ["-I", ROOT, src, "-o", exe]
+
+
+def preprocess_cmd(argv, flags, src):
+    if is_msvc(argv):
+        return argv + ["/nologo"] + flags + ["/I", ROOT, "/EP", src]
+    return argv + flags + ["-I", ROOT, "-E", src]
+
+
+def run_cell(cell):
+    """Compile and run one cell; returns its result record."""
+    argv, flags, host = cell["argv"], cell["flags"], cell["host"]
+    workdir = tempfile.mkdtemp(prefix=".matrix_", dir=ROOT)
+    try:
+        src = os.path.join(workdir, "cell.c")
+        exe = os.path.join(workdir, "cell.exe")
+        with open(src, "w") as f:
+            f.write(cell["source"])
+        result = {"status": FAILED, "warnings": False, "detected": None}
+        if cell["detect"]:
+            with open(src, "a") as f:
+                f.write('"@detect" %s\n' % cell["detect"])
+            rc, out, _ = run(preprocess_cmd(argv, flags, src))
+            found = re.search(r'"@detect"\s*(\w+)', out) if rc == 0 else None
+            result["detected"] = found and found.group(1)
+            with open(src, "w") as f:
+                f.write(cell["source"])
+        if host:
+            rc, out, err = run(preprocess_cmd(argv, flags, src))
+            if rc != 0:
+                result["log"] = err[-4000:]
+                return result
+            pre = os.path.join(workdir, "cell.i.c")
+            with open(pre, "w") as f:
+                f.write(out)
+            rc, out, log = run(compile_cmd(host, [], pre, exe))
+            log = err + out + log
+        else:
+            rc, out, log = run(compile_cmd(argv, flags, src, exe),
+                               cwd=workdir)
+            log = out + log
+        result["log"] = log[-4000:]
+        if rc != 0:
+            return result
+        result["warnings"] = bool(re.search(r"warning", log, re.I))
+        rc, out, err = run([exe])
+        result["status"] = PASSED if rc == 0 else BROKEN
+        result["log"] += (out + err)[-4000:]
+        return result
+    finally:
+        shutil.rmtree(workdir, ignore_errors=True)
+
+
+def header_hash(test):
+    h = hashlib.sha256()
+    for name in (test["file_name"], "va_opt_config.h"):
+        path = os.path.join(ROOT, name)
+        if os.path.exists(path):
+            with open(path, "rb") as f:
+                h.update(f.read())
+    return h.hexdigest()
+
+
+def cell_key(cell, digest):
+    h = hashlib.sha256()
+    h.update(json.dumps([digest, cell["argv"], cell["flags"], cell["host"],
+                         cell["source"], cell["detect"], cell["versions"]])
+             .encode())
+    return h.hexdigest()
+
+
+def cached(cell, key, use_cache):
+    path = os.path.join(CACHE, key + ".json")
+    if use_cache and os.path.exists(path):
+        with open(path) as f:
+            return json.load(f), True
+    result = run_cell(cell)
+    os.makedirs(CACHE, exist_ok=True)
+    with open(path + ".tmp", "w") as f:
+        json.dump(result, f)
+    os.replace(path + ".tmp", path)
+    return result, False
+
+
+def cell_text(result, auto):
+    text = (AUTO if auto else "") + result["status"]
+    if result["warnings"] and result["status"] != FAILED:
+        text += WARNED
+    return text
+
+
+def width(text):
+    """Columns `text` takes in a monospace editor; the status marks are
+    double width and their variation selectors take none."""
+    return sum(0 if c == "\ufe0f" else 2 if ord(c) >= 0x2100 else 1
+               for c in text)
+
+
+def update_readme(rows, columns):
+    """Rewrite or append the matrix rows in `rows` (name -> cell texts)."""
+    with open(README) as f:
+        lines = f.read().split("\n")
+    head = next(i for i, l in enumerate(lines) if l.startswith("| CC "))
+    widths = [len(c) for c in lines[head].split("|")[1:-1]]
+    names = [c.strip() for c in lines[head].split("|")[2:-1]]
+    end = head + 2
+    while end < len(lines) and lines[end].startswith("|"):
+        end += 1
+    for name, cells in rows.items():
+        values = [name] + [cells.get(columns.get(n), "") for n in names]
+        line = "|" + "|".join(
+            " " + v + " " * max(1, w - 1 - width(v))
+            for v, w in zip(values, widths)) + "|"
+        for i in range(head + 2, end):
+            if lines[i].split("|")[1].strip() == name:
+                lines[i] = line
+                break
+        else:
+            lines.insert(end, line)
+            end += 1
+    if rows and LOCAL_NOTE not in lines:
+        notes = end + 1
+        while notes < len(lines) and lines[notes].startswith("\\*"):
+            notes += 1
+        lines[notes - 1] = lines[notes - 1].rstrip() + "  "
+        lines.insert(notes, LOCAL_NOTE)
+    with open(README, "w") as f:
+        f.write("\n".join(lines))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--yaml", default=YAML)
+    ap.add_argument("--compiler", nargs="+", default=[], metavar="NICK=CMD",
+                    help="local command for a test.yaml nickname")
+    ap.add_argument("--host-cc", default=None,
+                    help="compiler for local_compile entries (default $CC)")
+    ap.add_argument("--jobs", type=int, default=os.cpu_count() or 1)
+    ap.add_argument("--no-cache", action="store_true")
+    ap.add_argument("--readme", action="store_true",
+                    help="rewrite the README matrix rows for these results")
+    args = ap.parse_args()
+
+    local = dict(LOCAL)
+    for spec in args.compiler:
+        nick, _, cmd = spec.partition("=")
+        local[nick] = cmd
+    host = shlex.split(args.host_cc or os.environ.get("CC") or "cc")
+    config = load_yaml(args.yaml)
+
+    cells, versions = [], {}
+    for compiler in config["compilers"]:
+        cmd = local.get(compiler["nickname"])
+        if not cmd or not shutil.which(shlex.split(cmd)[0]):
+            continue
+        argv = shlex.split(cmd)
+        if cmd not in versions:
+            versions[cmd] = banner(argv)
+        use_host = compiler.get("local_compile") and not is_msvc(argv)
+        for test in config["tests"]:
+            digest = header_hash(test)
+            for variant in test["variants"]:
+                cell = {"compiler": compiler, "test": test,
+                        "variant": variant, "argv": argv,
+                        "name": row_name(compiler, versions[cmd]),
+                        "flags": flags_of(compiler),
+                        "host": host if use_host else None,
+                        "source": cell_source(test, variant),
+                        "detect": (test.get("detect_macro")
+                                   if variant.get("auto") else None),
+                        "versions": [versions[cmd],
+                                     banner(host) if use_host else ""]}
+                cell["key"] = cell_key(cell, digest)
+                cells.append(cell)
+    if not cells:
+        sys.stderr.write("no test.yaml compiler is installed\n")
+        return 1
+
+    pool = concurrent.futures.ThreadPoolExecutor(max(1, args.jobs))
+    jobs = [pool.submit(cached, c, c["key"], not args.no_cache)
+            for c in cells]
+    results = [job.result() for job in jobs]
+    pool.shutdown()
+
+    rows, columns, hits, failed = {}, {}, 0, 0
+    detected = {}
+    for cell, (result, hit) in zip(cells, results):
+        hits += hit
+        if cell["detect"]:
+            detected[cell["compiler"]["display_name"], cell["test"]["group"]] \
+                = result["detected"]
+    for cell, (result, hit) in zip(cells, results):
+        compiler, test, variant = cell["compiler"], cell["test"], cell["variant"]
+        auto = variant.get("auto")
+        failed += result["status"] != PASSED and not auto
+        sys.stderr.write("%-28s %-8s %-8s %s%s\n" % (
+            cell["name"], test["group"], variant["variant"],
+            result["status"], " (cached)" if hit else ""))
+        if auto or variant.get("include_in_table") is False:
+            continue
+        name = cell["name"]
+        columns[variant["display_name"]] = variant["variant"]
+        is_auto = str(detected.get((compiler["display_name"],
+                                    test["group"]))) == \
+            str(variant.get("detect_value"))
+        rows.setdefault(name, {})[variant["variant"]] = cell_text(result,
+                                                                 is_auto)
+    sys.stderr.write("%d cells, %d cached, %d not passing\n"
+                     % (len(cells), hits, failed))
+    for name, cells_ in rows.items():
+        print("%-28s %s" % (name, "  ".join(
+            "%s %s" % (v, cells_[v]) for v in cells_)))
+    if args.readme:
+        update_readme(rows, columns)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,211 @@
+# SPDX-License-Identifier: CC0-1.0
+"""Generate slim single-implementation copies of va_opt.h.
+
+The compiler resolves va_opt.h for one forced implementation (`cc -E -dM`),
+and only the macros reachable from the public VA_* names are written out,
+in their original order. The output has no detection chain, no other
+implementations and no TEST_VA_OPT scaffolding. The VA_OPT_MAX_EACH knob stays
+configurable: steps that only exist for larger settings are kept behind the
+same #if guards as in va_opt.h.
+
+With --check, each slim header is compared with va_opt.h: the header's own
+test suite is preprocessed against both and must give the same tokens, and
+is then built and run against the slim header.
+
+    python3 tools/slim_header.py --out-dir slim --check
+"""
+
+import argparse
+import os
+import re
+import shlex
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+HEADER = os.path.join(ROOT, "va_opt.h")
+
+IMPLS = {
+    "native": "VA_OPT_USE_NATIVE",
+    "gnu": "VA_OPT_USE_GNU",
+    "c99": "VA_OPT_USE_C99",
+}
+
+# Knob -> settings to resolve the header at; the first one is the smallest.
+KNOBS = {"VA_OPT_MAX_EACH": [32, 64, 96, 128]}
+
+# Not reachable from a VA_* name, but part of what the header promises.
+EXTRA_ROOTS = ["VA_OPT_H", "NTRNLVA_IMPL", "NTRNLVA_IMPL_NATIVE",
+               "NTRNLVA_IMPL_GNU", "NTRNLVA_IMPL_MSVC", "NTRNLVA_IMPL_C99",
+               "NTRNLVA_MSVC_TRADITIONAL"]
+
+_DEFINE = re.compile(r"#define ([A-Za-z_]\w*)(\([^)]*\))? ?(.*)$")
+_IDENT = re.compile(r"[A-Za-z_]\w*")
+
+
+def split_cc(cc):
+    return shlex.split(cc or os.environ.get("CC") or "cc")
+
+
+def dump_macros(cc, defines, path=HEADER):
+    """Map macro name -> (parameter list or None, body) after `path`."""
+    argv = split_cc(cc) + ["-x", "c", "-E", "-dM"]
+    argv += ["-D%s" % d for d in defines] + [path]
+    macros = {}
+    for line in subprocess.check_output(argv).decode().splitlines():
+        m = _DEFINE.match(line)
+        if m:
+            params = m.group(2)
+            if params is not None:
+                params = [p.strip() for p in params[1:-1].split(",")]
+            macros[m.group(1)] = (params, m.group(3))
+    return macros
+
+
+def reachable(macros):
+    names = sorted(macros)
+    todo = [n for n in names if n.startswith("VA_")]
+    todo += [n for n in EXTRA_ROOTS if n in macros]
+    seen = set()
+    while todo:
+        name = todo.pop()
+        if name in seen:
+            continue
+        seen.add(name)
+        for ident in _IDENT.findall(macros[name][1]):
+            # Prefixes cover names built with ##, e.g. NTRNLVA_OPT_IMPL_ ## 0.
+            todo += [n for n in names if n.startswith(ident)]
+    return seen
+
+
+def spell(name, params, body):
+    head = name if params is None else "%s(%s)" % (name, ", ".join(params))
+    return ("#define %s %s" % (head, body)).rstrip()
+
+
+def generate(cc, impl):
+    with open(HEADER) as f:
+        source = f.read()
+    force = IMPLS[impl]
+    with tempfile.NamedTemporaryFile("w", suffix=".h") as empty:
+        builtin = set(dump_macros(cc, [force], empty.name))
+    knob, levels = next(iter(KNOBS.items()))
+    by_level = [dump_macros(cc, [force, "%s=%d" % (knob, n)]) for n in levels]
+    default = dump_macros(cc, [force])
+    macros = by_level[-1]
+    keep = reachable(macros) - builtin - set(KNOBS)
+
+    def first_level(name):
+        return next(i for i, m in enumerate(by_level) if name in m)
+
+    def position(name):
+        m = re.search(r"#\s*define\s+%s\b" % re.escape(name), source)
+        return m.start() if m else len(source)
+
+    version = default["VA_OPT_H_VERSION"][1]
+    out = [
+        "/* SPDX-License-Identifier: Apache-2.0 AND BSL-1.0 AND CC0-1.0 */",
+        "",
+        "/* Generated by tools/slim_header.py from va_opt.h version %s"
+        % version,
+        "for %s. Do not edit; see va_opt.h for the licenses, documentation"
+        % force,
+        "and the code these definitions come from. */",
+        "",
+        "#ifndef VA_OPT_H",
+        "#if defined(_MSVC_TRADITIONAL) && _MSVC_TRADITIONAL",
+        '    #error "va_opt_%s.h needs a conforming preprocessor, use va_opt.h"'
+        % impl,
+        "#endif",
+        "",
+        "#ifndef %s" % knob,
+        "    #define %s %s" % (knob, default[knob][1]),
+        "#endif",
+        "#if %s > %d" % (knob, levels[-1]),
+        '    #error "%s must not exceed %d"' % (knob, levels[-1]),
+        "#endif",
+        "",
+    ]
+    guard = 0
+    for name in sorted(keep, key=position):
+        level = first_level(name)
+        if level != guard:
+            if guard:
+                out.append("#endif")
+            if level:
+                out.append("#if %s > %d" % (knob, levels[level - 1]))
+            guard = level
+        out.append(spell(name, *macros[name]))
+    if guard:
+        out.append("#endif")
+    out += ["", "#endif /* VA_OPT_H */", ""]
+    return "\n".join(out)
+
+
+def test_source(header_name):
+    """The TEST_VA_OPT blocks of va_opt.h, placed after `header_name`."""
+    with open(HEADER) as f:
+        source = f.read()
+    blocks = re.findall(
+        r"^#ifdef TEST_VA_OPT\n(.*?)^#endif /\* TEST_VA_OPT \*/", source,
+        re.S | re.M)
+    return '#include "%s"\n#define TEST_VA_OPT\n%s' % (header_name,
+                                                       "".join(blocks))
+
+
+def tokens(text):
+    return re.findall(r'"(?:\\.|[^"\\])*"|\w+|\S', text)
+
+
+def check(cc, impl, slim_dir):
+    name = "va_opt_%s.h" % impl
+    cc_argv = split_cc(cc)
+    full = subprocess.check_output(
+        cc_argv + ["-x", "c", "-E", "-P", "-DTEST_VA_OPT",
+                   "-D" + IMPLS[impl], HEADER]).decode()
+    with tempfile.NamedTemporaryFile("w", suffix=".c", dir=slim_dir) as tu:
+        tu.write(test_source(name))
+        tu.flush()
+        slim = subprocess.check_output(
+            cc_argv + ["-E", "-P", "-I", slim_dir, tu.name]).decode()
+        if tokens(full) != tokens(slim):
+            sys.stderr.write("%s: preprocessed tests differ from va_opt.h\n"
+                             % name)
+            return False
+        exe = os.path.join(slim_dir, ".test_" + impl)
+        subprocess.check_call(cc_argv + ["-I", slim_dir, tu.name, "-o", exe])
+    try:
+        result = subprocess.run([exe], stdout=subprocess.PIPE)
+    finally:
+        os.unlink(exe)
+    summary = result.stdout.decode().strip().splitlines()
+    sys.stderr.write("%s: same tokens as va_opt.h, %s\n"
+                     % (name, summary[-1] if summary else "no output"))
+    return result.returncode == 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=None, help="compiler driver (default $CC)")
+    ap.add_argument("--impls", nargs="+", default=list(IMPLS),
+                    choices=list(IMPLS))
+    ap.add_argument("--out-dir", default=os.path.join(ROOT, "slim"))
+    ap.add_argument("--check", action="store_true",
+                    help="verify each slim header against va_opt.h")
+    args = ap.parse_args()
+
+    if not os.path.isdir(args.out_dir):
+        os.makedirs(args.out_dir)
+    ok = True
+    for impl in args.impls:
+        path = os.path.join(args.out_dir, "va_opt_%s.h" % impl)
+        with open(path, "w") as f:
+            f.write(generate(args.cc, impl))
+        if args.check:
+            ok = check(args.cc, impl, os.path.abspath(args.out_dir)) and ok
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,425 @@
+/* SPDX-License-Identifier: CC0-1.0 */
+
+#ifndef VA_ASSERT_H
+#define VA_ASSERT_H
+
+/*
+Assertions with optional formatted messages, kept off the hot path.
+Licensed as CC0 1.0 Universal.
+To view a copy of this license,
+visit https://creativecommons.org/publicdomain/zero/1.0/
+
+EXAMPLE USAGE:
+
+#define VA_ASSERT_IMPLEMENTATION   // in exactly one source file
+#include "va_assert.h"
+
+VA_ASSERT(n > 0);                          // removed under NDEBUG
+VA_ASSERT(i < n, "index %d of %d", i, n);
+VA_CHECK(fd >= 0, "open %s failed", path); // always evaluated
+
+main.c:12: read_all: Assertion `i < n' failed: index 7 of 4
+
+CODE AT THE CALL SITE:
+  A call site compiles to the test, a branch the compiler is told is not
+  taken, and a call to a noinline, cold, noreturn handler. Without a message
+  the call passes one pointer to a static const descriptor (expression, file,
+  line, function). With a message, VA_OPT_ELSE picks a variant whose
+  descriptor also holds fmt and one type tag per argument, from _Generic in
+  C and overloading in C++. The arguments are packed into an array of 8-byte
+  values on the stack, and its address is the call's second argument. The
+  message is formatted inside the handler, so no printf call and no format
+  string per site is emitted where the assertion is. GCC and Clang move the
+  failure block to .text.unlikely when optimizing for speed.
+
+  fmt must be a string literal. It is checked against the arguments like
+  printf's (the check is never executed). Integers are passed as long long
+  or unsigned long long, floating values as double, char * as a string and
+  other pointers as void *. Conversions may use flags, width, precision and
+  `*`. An integer is converted to the type of the conversion's length
+  modifier, as printf converts it; %n consumes its argument and writes
+  nothing. Limits are VA_ASSERT_MAX_ARGS (default 16) arguments after fmt,
+  past which the call does not compile, and VA_ASSERT_MAX_MESSAGE (default
+  512) bytes of formatted message.
+
+FAILURE:
+  The handler writes the message to stderr and calls abort().
+  va_assert_set_handler() installs a function that receives the descriptor
+  and the formatted message instead. If it returns, abort() is still called.
+
+DISABLING:
+  VA_ASSERT expands to ((void)0) under NDEBUG, like assert(), and evaluates
+  nothing. VA_CHECK is never disabled.
+
+RUN TESTS:
+    cc -x c -DTEST_VA_ASSERT va_assert.h -o va_assert_test && ./va_assert_test
+*/
+
+#include <stdio.h>
+
+#include "va_internal.h"
+
+#ifndef VA_ASSERT_MAX_ARGS
+    #define VA_ASSERT_MAX_ARGS 16
+#endif
+#ifndef VA_ASSERT_MAX_MESSAGE
+    #define VA_ASSERT_MAX_MESSAGE 512
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define NTRNLVA_ASSERT_COLD                                                \
+      __attribute__((noinline, cold, noreturn))
+    #define NTRNLVA_ASSERT_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#elif defined(_MSC_VER)
+    #define NTRNLVA_ASSERT_COLD __declspec(noinline, noreturn)
+    #define NTRNLVA_ASSERT_UNLIKELY(x) (x)
+#else
+    #define NTRNLVA_ASSERT_COLD
+    #define NTRNLVA_ASSERT_UNLIKELY(x) (x)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct va_assert_site {
+  const char *expr;
+  const char *file;
+  const char *func;
+  int line;
+  int check; /* 1 for VA_CHECK */
+};
+
+/* Argument type tags */
+enum {
+  VA_ASSERT_INT = 1, /* long long */
+  VA_ASSERT_UINT,    /* unsigned long long */
+  VA_ASSERT_DOUBLE,  /* double */
+  VA_ASSERT_STRING,  /* const char * */
+  VA_ASSERT_POINTER  /* const void * */
+};
+
+struct va_assert_msg_site {
+  struct va_assert_site site;
+  const char *fmt;
+  unsigned char tags[VA_ASSERT_MAX_ARGS]; /* 0 after the last argument */
+};
+
+union va_assert_value {
+  long long i;
+  unsigned long long u;
+  double d;
+  const char *s;
+  const void *p;
+};
+
+typedef void (*va_assert_handler)(const struct va_assert_site *site,
+                                  const char *message);
+
+va_assert_handler va_assert_set_handler(va_assert_handler handler);
+
+NTRNLVA_ASSERT_COLD void va_assert_fail(const struct va_assert_site *site);
+NTRNLVA_ASSERT_COLD void
+va_assert_fail_args(const struct va_assert_msg_site *site,
+                    const union va_assert_value *args);
+
+#ifdef __cplusplus
+}
+#endif
+
+static inline union va_assert_value va_assert_pack_int(long long v) {
+  union va_assert_value a;
+  a.i = v;
+  return a;
+}
+static inline union va_assert_value va_assert_pack_uint(unsigned long long v) {
+  union va_assert_value a;
+  a.u = v;
+  return a;
+}
+static inline union va_assert_value va_assert_pack_double(double v) {
+  union va_assert_value a;
+  a.d = v;
+  return a;
+}
+static inline union va_assert_value va_assert_pack_string(const char *v) {
+  union va_assert_value a;
+  a.s = v;
+  return a;
+}
+static inline union va_assert_value va_assert_pack_pointer(const void *v) {
+  union va_assert_value a;
+  a.p = v;
+  return a;
+}
+
+#ifdef __cplusplus
+/* The tags are the sizes of these return types, taken without evaluating
+the argument, so they can initialize the static descriptor */
+char (&va_assert_tag(int))[VA_ASSERT_INT];
+char (&va_assert_tag(long))[VA_ASSERT_INT];
+char (&va_assert_tag(long long))[VA_ASSERT_INT];
+char (&va_assert_tag(unsigned))[VA_ASSERT_UINT];
+char (&va_assert_tag(unsigned long))[VA_ASSERT_UINT];
+char (&va_assert_tag(unsigned long long))[VA_ASSERT_UINT];
+char (&va_assert_tag(double))[VA_ASSERT_DOUBLE];
+char (&va_assert_tag(long double))[VA_ASSERT_DOUBLE];
+char (&va_assert_tag(const char *))[VA_ASSERT_STRING];
+char (&va_assert_tag(const void *))[VA_ASSERT_POINTER];
+
+static inline va_assert_value va_assert_pack(int v) {
+  return va_assert_pack_int(v);
+}
+static inline va_assert_value va_assert_pack(long v) {
+  return va_assert_pack_int(v);
+}
+static inline va_assert_value va_assert_pack(long long v) {
+  return va_assert_pack_int(v);
+}
+static inline va_assert_value va_assert_pack(unsigned v) {
+  return va_assert_pack_uint(v);
+}
+static inline va_assert_value va_assert_pack(unsigned long v) {
+  return va_assert_pack_uint(v);
+}
+static inline va_assert_value va_assert_pack(unsigned long long v) {
+  return va_assert_pack_uint(v);
+}
+static inline va_assert_value va_assert_pack(double v) {
+  return va_assert_pack_double(v);
+}
+static inline va_assert_value va_assert_pack(long double v) {
+  return va_assert_pack_double((double)v);
+}
+static inline va_assert_value va_assert_pack(const char *v) {
+  return va_assert_pack_string(v);
+}
+static inline va_assert_value va_assert_pack(const void *v) {
+  return va_assert_pack_pointer(v);
+}
+    #define NTRNLVA_ASSERT_TAG(x) ((unsigned char)sizeof(va_assert_tag(x)))
+    #define NTRNLVA_ASSERT_PACK(x) va_assert_pack(x)
+    #define NTRNLVA_ASSERT_STATIC static_assert
+#else
+    #define NTRNLVA_ASSERT_TAG(x)                                              \
+      NTRNLVA_GENERIC_KIND(x, VA_ASSERT_INT, VA_ASSERT_UINT, VA_ASSERT_DOUBLE, \
+                           VA_ASSERT_DOUBLE, VA_ASSERT_STRING,                 \
+                           VA_ASSERT_POINTER)
+    #define NTRNLVA_ASSERT_PACK(x)                                             \
+      NTRNLVA_GENERIC_KIND(x, va_assert_pack_int, va_assert_pack_uint,         \
+                           va_assert_pack_double, va_assert_pack_double,       \
+                           va_assert_pack_string, va_assert_pack_pointer)(x)
+    #define NTRNLVA_ASSERT_STATIC _Static_assert
+#endif /* __cplusplus */
+
+#define NTRNLVA_ASSERT_PLAIN(check, cond, ...)                                 \
+  do {                                                                         \
+    if (NTRNLVA_ASSERT_UNLIKELY(!(cond))) {                                    \
+      static const struct va_assert_site va_assert_site_ = {                   \
+          #cond, __FILE__, __func__, __LINE__, check};                         \
+      va_assert_fail(&va_assert_site_);                                        \
+    }                                                                          \
+  } while (0)
+
+/* Without arguments after fmt, no array is built and the handler gets
+NULL */
+#define NTRNLVA_ASSERT_MSG(check, cond, fmt, ...)                              \
+  do {                                                                         \
+    NTRNLVA_ASSERT_STATIC(VA_NARGS(__VA_ARGS__) <= VA_ASSERT_MAX_ARGS,         \
+                          "more than VA_ASSERT_MAX_ARGS arguments");           \
+    if (NTRNLVA_ASSERT_UNLIKELY(!(cond))) {                                    \
+      static const struct va_assert_msg_site va_assert_site_ = {               \
+          {#cond, __FILE__, __func__, __LINE__, check},                        \
+          fmt,                                                                 \
+          {VA_MAP(NTRNLVA_ASSERT_TAG, __VA_ARGS__) VA_NOPT((__VA_ARGS__), 0)}};\
+      VA_OPT((__VA_ARGS__), const union va_assert_value va_assert_args_[] = { \
+                                VA_MAP(NTRNLVA_ASSERT_PACK, __VA_ARGS__)};)    \
+      NTRNLVA_FORMAT_CHECK(fmt, __VA_ARGS__);                                  \
+      va_assert_fail_args(&va_assert_site_,                                    \
+                          VA_OPT((__VA_ARGS__), va_assert_args_)               \
+                              VA_NOPT((__VA_ARGS__), 0));                      \
+    }                                                                          \
+  } while (0)
+
+#define NTRNLVA_ASSERT(check, cond, ...)                                       \
+  VA_OPT_ELSE((__VA_ARGS__), NTRNLVA_ASSERT_MSG,                               \
+              NTRNLVA_ASSERT_PLAIN)(check, cond, __VA_ARGS__)
+
+#define VA_CHECK(cond, ...) NTRNLVA_ASSERT(1, cond, __VA_ARGS__)
+#ifdef NDEBUG
+    #define VA_ASSERT(cond, ...) ((void)0)
+#else
+    #define VA_ASSERT(cond, ...) NTRNLVA_ASSERT(0, cond, __VA_ARGS__)
+#endif
+
+#if defined(VA_ASSERT_IMPLEMENTATION) || defined(TEST_VA_ASSERT)
+#define NTRNLVA_RENDER_IMPLEMENTATION
+#include "va_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static va_assert_handler va_assert_handler_;
+
+va_assert_handler va_assert_set_handler(va_assert_handler handler) {
+  va_assert_handler previous = va_assert_handler_;
+  va_assert_handler_ = handler;
+  return previous;
+}
+
+/* Hands the packed arguments to va_render as their tags say */
+struct va_assert_reader {
+  const unsigned char *tag;
+  const unsigned char *end;
+  const union va_assert_value *args;
+};
+
+static int va_assert_next(void *ctx, struct va_render_arg *a) {
+  struct va_assert_reader *r = (struct va_assert_reader *)ctx;
+  union va_assert_value v;
+  if (r->tag == r->end || !*r->tag) {
+    return 0;
+  }
+  v = *r->args++;
+  memset(a, 0, sizeof(*a));
+  switch (*r->tag++) {
+  case VA_ASSERT_INT:
+    a->i = v.i;
+    a->u = v.u;
+    a->d = (double)v.i;
+    break;
+  case VA_ASSERT_UINT:
+    a->i = v.i;
+    a->u = v.u;
+    a->d = (double)v.u;
+    break;
+  case VA_ASSERT_DOUBLE:
+    a->d = v.d;
+    a->i = (long long)v.d;
+    a->u = (unsigned long long)a->i;
+    break;
+  case VA_ASSERT_STRING:
+    a->s = v.s;
+    a->slen = v.s ? strlen(v.s) : 0;
+    a->p = v.p;
+    break;
+  default:
+    a->p = v.p;
+    break;
+  }
+  return 1;
+}
+
+/* Renders the site's format with args into out, terminated */
+static void va_assert_render(char *out, size_t cap,
+                             const struct va_assert_msg_site *site,
+                             const union va_assert_value *args) {
+  struct va_assert_reader r;
+  r.tag = site->tags;
+  r.end = site->tags + VA_ASSERT_MAX_ARGS;
+  r.args = args;
+  out[va_render(out, 0, cap, site->fmt, va_assert_next, &r)] = '\0';
+}
+
+NTRNLVA_ASSERT_COLD static void
+va_assert_report(const struct va_assert_site *site, const char *message) {
+  if (va_assert_handler_) {
+    va_assert_handler_(site, message);
+  } else {
+    fflush(stdout);
+    fprintf(stderr, "%s:%d: %s: %s `%s' failed%s%s\n", site->file,
+            site->line, site->func, site->check ? "Check" : "Assertion",
+            site->expr, *message ? ": " : ".", message);
+  }
+  abort();
+}
+
+void va_assert_fail_args(const struct va_assert_msg_site *site,
+                         const union va_assert_value *args) {
+  char message[VA_ASSERT_MAX_MESSAGE];
+  va_assert_render(message, sizeof(message), site, args);
+  va_assert_report(&site->site, message);
+}
+
+void va_assert_fail(const struct va_assert_site *site) {
+  va_assert_report(site, "");
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VA_ASSERT_IMPLEMENTATION */
+
+#ifdef TEST_VA_ASSERT
+#include <setjmp.h>
+
+#define NTRNLVA_TEST
+#include "va_internal.h"
+
+static jmp_buf trap;
+static char last[VA_ASSERT_MAX_MESSAGE + 128];
+
+/* Records what would have been printed and jumps back instead of aborting */
+static void record(const struct va_assert_site *site, const char *message) {
+  snprintf(last, sizeof(last), "%s `%s' in %s:%s",
+           site->check ? "Check" : "Assertion", site->expr, site->func,
+           message);
+  longjmp(trap, 1);
+}
+
+/* Returns 1 if fn(x) failed, with last set */
+static int fails(void (*fn)(int), int x) {
+  last[0] = '\0';
+  if (setjmp(trap)) {
+    return 1;
+  }
+  fn(x);
+  return 0;
+}
+
+static void assert_plain(int x) { VA_ASSERT(x > 0); }
+static void assert_fmt_only(int x) { VA_ASSERT(x > 0, "no arguments"); }
+static void assert_args(int x) {
+  const char *name = "alice";
+  VA_ASSERT(x > 0, "x=%d %s %.2f %5u|%-3c|%x %%", x, name, 0.25, 7u, 'z',
+            255);
+}
+static void assert_star(int x) {
+  VA_ASSERT(x > 0, "[%*d] [%.*s]", 4, x, 2, "abcdef");
+}
+static void check_side_effect(int x) { VA_CHECK(side_effect() < x); }
+static void assert_side_effect(int x) { VA_ASSERT(side_effect() < x, "m"); }
+
+int main(void) {
+  va_assert_set_handler(record);
+
+  EXPECT(fails(assert_plain, 1), 0);
+  EXPECT(fails(assert_plain, 0), 1);
+  EXPECT(strcmp(last, "Assertion `x > 0' in assert_plain:"), 0);
+  EXPECT(fails(assert_fmt_only, 0), 1);
+  EXPECT(strcmp(last, "Assertion `x > 0' in assert_fmt_only:no arguments"),
+         0);
+  EXPECT(fails(assert_args, 3), 0);
+  EXPECT(fails(assert_args, -3), 1);
+  EXPECT(strcmp(last, "Assertion `x > 0' in assert_args:"
+                      "x=-3 alice 0.25     7|z  |ff %"),
+         0);
+  EXPECT(fails(assert_star, -1), 1);
+  EXPECT(strcmp(last, "Assertion `x > 0' in assert_star:[  -1] [ab]"), 0);
+
+  /* The condition is evaluated once, and only the check reports "Check" */
+  EXPECT(fails(check_side_effect, 0), 1);
+  EXPECT(evaluated, 1);
+  EXPECT(strncmp(last, "Check `side_effect() < x'", 25), 0);
+  EXPECT(fails(assert_side_effect, 0), 1);
+  EXPECT(evaluated, 2);
+
+  return test_report();
+}
+#endif /* TEST_VA_ASSERT */
+
+#endif /* VA_ASSERT_H */
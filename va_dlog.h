@@ -0,0 +1,669 @@
+/* SPDX-License-Identifier: CC0-1.0 */
+
+#ifndef VA_DLOG_H
+#define VA_DLOG_H
+
+/*
+Deferred binary logging on top of va_opt.h and va_log.h.
+Licensed as CC0 1.0 Universal.
+To view a copy of this license,
+visit https://creativecommons.org/publicdomain/zero/1.0/
+
+EXAMPLE USAGE:
+
+#define VA_DLOG_IMPLEMENTATION   // in exactly one source file
+#include "va_dlog.h"
+
+va_dlog_start(stderr);
+VA_DLOG_INFO("served %s in %d us", path, us);
+VA_DLOG(WARN, "queue full");
+va_dlog_stop();                  // drains every ring, then returns
+
+HOW IT WORKS:
+  Each call site owns a static const descriptor: the "[LEVEL] " fmt "\n"
+  string, the argument count from VA_NARGS, and one type tag per argument
+  from _Generic. It is built by the compiler, so nothing is registered at
+  run time. The call copies its arguments' raw bytes, behind a pointer to the
+  descriptor, into a ring owned by the calling thread (single producer,
+  single consumer, lock-free). A background thread started by
+  va_dlog_start() drains the rings, formats the records with the
+  descriptors' formats and writes them in batches.
+
+  Integers are stored as long long or unsigned long long, floating values as
+  double or long double, pointers as void *. A char * argument is stored as
+  its address, for %p, and only under %s also copied as a string, up to the
+  space left in the record. Each call site finds its %s arguments by scanning
+  its format once. fmt must be a string literal,
+  and it is checked against the arguments like printf's (the check is never
+  executed). Conversions may use flags, width, precision and `*`. An integer
+  is converted to the type of the conversion's length modifier, as printf
+  converts it; %n consumes its argument and writes nothing. A formatted line
+  is cut at 64 KiB, the writer's batch.
+
+LEVELS:
+  VA_DLOG_TRACE .. VA_DLOG_ERROR follow VA_LOG_LEVEL from va_log.h. Calls
+  below it expand to ((void)0) and evaluate nothing.
+
+LIMITS:
+  Requires C11 (_Generic, _Thread_local, <stdatomic.h>) and POSIX threads.
+  - VA_DLOG_MAX_ARGS (default 16) arguments per call
+  - VA_DLOG_MAX_RECORD (default 512) bytes of arguments per call
+  - VA_DLOG_RING_SIZE (default 1 << 20) bytes per thread, a power of two
+  A thread whose ring is full waits for the writer. Calls made while the
+  logger is stopped are dropped. Rings live until va_dlog_stop(), which must
+  not run while other threads are still logging.
+
+RUN TESTS:
+    cc -x c -pthread -DTEST_VA_DLOG va_dlog.h -o va_dlog_test && ./va_dlog_test
+*/
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "va_internal.h"
+#include "va_log.h"
+
+#ifndef VA_DLOG_MAX_ARGS
+    #define VA_DLOG_MAX_ARGS 16
+#endif
+#ifndef VA_DLOG_MAX_RECORD
+    #define VA_DLOG_MAX_RECORD 512
+#endif
+#ifndef VA_DLOG_RING_SIZE
+    #define VA_DLOG_RING_SIZE (1 << 20)
+#endif
+
+/* Argument type tags, as stored in a record */
+enum {
+  VA_DLOG_INT = 1,  /* long long */
+  VA_DLOG_UINT,     /* unsigned long long */
+  VA_DLOG_DOUBLE,   /* double */
+  VA_DLOG_LDOUBLE,  /* long double */
+  VA_DLOG_STRING,   /* char *, unsigned short length, then the bytes */
+  VA_DLOG_POINTER   /* void * */
+};
+
+struct va_dlog_site {
+  const char *fmt;
+  unsigned char nargs;
+  unsigned char tags[VA_DLOG_MAX_ARGS];
+};
+
+int va_dlog_start(FILE *out);
+void va_dlog_flush(void);
+void va_dlog_stop(void);
+void va_dlog_push(const struct va_dlog_site *site, const unsigned char *rec,
+                  size_t size);
+unsigned long long va_dlog_scan(atomic_ullong *cache, const char *fmt);
+
+/* Bit k is set when argument k is taken by a %s conversion of fmt. A call
+site scans its format once and keeps the bits in cache; bit 63 marks them as
+scanned. */
+static inline unsigned long long va_dlog_text(atomic_ullong *cache,
+                                              const char *fmt) {
+  unsigned long long bits = atomic_load_explicit(cache, memory_order_relaxed);
+  return bits ? bits : va_dlog_scan(cache, fmt);
+}
+
+static inline unsigned char *va_dlog_put_int(unsigned char *p,
+                                             unsigned char *end, int text,
+                                             long long v) {
+  (void)end;
+  (void)text;
+  memcpy(p, &v, sizeof(v));
+  return p + sizeof(v);
+}
+static inline unsigned char *va_dlog_put_uint(unsigned char *p,
+                                              unsigned char *end, int text,
+                                              unsigned long long v) {
+  (void)end;
+  (void)text;
+  memcpy(p, &v, sizeof(v));
+  return p + sizeof(v);
+}
+static inline unsigned char *va_dlog_put_double(unsigned char *p,
+                                                unsigned char *end, int text,
+                                                double v) {
+  (void)end;
+  (void)text;
+  memcpy(p, &v, sizeof(v));
+  return p + sizeof(v);
+}
+static inline unsigned char *va_dlog_put_ldouble(unsigned char *p,
+                                                 unsigned char *end, int text,
+                                                 long double v) {
+  (void)end;
+  (void)text;
+  memcpy(p, &v, sizeof(v));
+  return p + sizeof(v);
+}
+static inline unsigned char *va_dlog_put_pointer(unsigned char *p,
+                                                 unsigned char *end, int text,
+                                                 const void *v) {
+  (void)end;
+  (void)text;
+  memcpy(p, &v, sizeof(v));
+  return p + sizeof(v);
+}
+/* The pointer is always stored, for %p. The bytes are copied only when text,
+for %s, since other conversions do not promise a terminated string. end
+leaves a slot per argument after it, so only strings are cut. Once earlier
+arguments pass end, a string keeps just its pointer and length, inside its
+slot. */
+static inline unsigned char *va_dlog_put_string(unsigned char *p,
+                                                unsigned char *end, int text,
+                                                const char *v) {
+  ptrdiff_t room =
+      end - p - (ptrdiff_t)(sizeof(v) + sizeof(unsigned short));
+  size_t n = !text ? 0 : v ? strlen(v) : 6;
+  unsigned short len =
+      (unsigned short)(room <= 0 ? 0 : n < (size_t)room ? n : (size_t)room);
+  memcpy(p, &v, sizeof(v));
+  memcpy(p + sizeof(v), &len, sizeof(len));
+  memcpy(p + sizeof(v) + sizeof(len), v ? v : "(null)", len);
+  return p + sizeof(v) + sizeof(len) + len;
+}
+
+/* Largest stored size of one argument, a string's bytes aside */
+#define NTRNLVA_DLOG_SLOT 16
+
+#if VA_DLOG_MAX_RECORD <= VA_DLOG_MAX_ARGS * NTRNLVA_DLOG_SLOT ||              \
+    VA_DLOG_MAX_RECORD > 65535
+    #error "VA_DLOG_MAX_RECORD must exceed 16 bytes an argument, fit 16 bits"
+#endif
+#if VA_DLOG_MAX_ARGS > 63
+    #error "VA_DLOG_MAX_ARGS must fit the 63 bits of va_dlog_text()"
+#endif
+
+#define NTRNLVA_DLOG_KIND(x)                                                   \
+  NTRNLVA_GENERIC_KIND(x, VA_DLOG_INT, VA_DLOG_UINT, VA_DLOG_DOUBLE,           \
+                       VA_DLOG_LDOUBLE, VA_DLOG_STRING, VA_DLOG_POINTER)
+#define NTRNLVA_DLOG_PUT(i, x)                                                 \
+  va_dlog_p_ =                                                                 \
+      NTRNLVA_GENERIC_KIND(x, va_dlog_put_int, va_dlog_put_uint,               \
+                           va_dlog_put_double, va_dlog_put_ldouble,            \
+                           va_dlog_put_string, va_dlog_put_pointer)            \
+      (va_dlog_p_, va_dlog_end_, (int)(va_dlog_text_ >> (i) & 1), (x));
+
+#define NTRNLVA_DLOG_EMIT(tag, fmt, ...)                                       \
+  do {                                                                         \
+    static const struct va_dlog_site va_dlog_site_ = {                         \
+        "[" tag "] " fmt "\n", VA_NARGS(__VA_ARGS__),                          \
+        {VA_MAP(NTRNLVA_DLOG_KIND, __VA_ARGS__) VA_NOPT((__VA_ARGS__), 0)}};  \
+    VA_OPT((__VA_ARGS__), static atomic_ullong va_dlog_scan_;)                 \
+    _Static_assert(VA_NARGS(__VA_ARGS__) <= VA_DLOG_MAX_ARGS,                  \
+                   "more than VA_DLOG_MAX_ARGS arguments");                    \
+    unsigned char va_dlog_rec_[VA_DLOG_MAX_RECORD];                            \
+    unsigned char *va_dlog_p_ = va_dlog_rec_;                                  \
+    unsigned char *va_dlog_end_ =                                              \
+        va_dlog_rec_ + sizeof(va_dlog_rec_) -                                  \
+        VA_DLOG_MAX_ARGS * NTRNLVA_DLOG_SLOT;                                  \
+    unsigned long long va_dlog_text_ =                                         \
+        VA_OPT((__VA_ARGS__), va_dlog_text(&va_dlog_scan_, fmt))               \
+            VA_NOPT((__VA_ARGS__), 0);                                         \
+    (void)va_dlog_end_;                                                        \
+    (void)va_dlog_text_;                                                       \
+    NTRNLVA_FORMAT_CHECK(fmt, __VA_ARGS__);                                    \
+    VA_FOR_EACH_I(NTRNLVA_DLOG_PUT, __VA_ARGS__)                               \
+    va_dlog_push(&va_dlog_site_, va_dlog_rec_,                                 \
+                 (size_t)(va_dlog_p_ - va_dlog_rec_));                         \
+  } while (0)
+
+#if VA_LOG_LEVEL <= VA_LOG_LEVEL_TRACE
+    #define VA_DLOG_TRACE(fmt, ...) NTRNLVA_DLOG_EMIT("TRACE", fmt, __VA_ARGS__)
+#else
+    #define VA_DLOG_TRACE(fmt, ...) ((void)0)
+#endif
+#if VA_LOG_LEVEL <= VA_LOG_LEVEL_DEBUG
+    #define VA_DLOG_DEBUG(fmt, ...) NTRNLVA_DLOG_EMIT("DEBUG", fmt, __VA_ARGS__)
+#else
+    #define VA_DLOG_DEBUG(fmt, ...) ((void)0)
+#endif
+#if VA_LOG_LEVEL <= VA_LOG_LEVEL_INFO
+    #define VA_DLOG_INFO(fmt, ...) NTRNLVA_DLOG_EMIT("INFO", fmt, __VA_ARGS__)
+#else
+    #define VA_DLOG_INFO(fmt, ...) ((void)0)
+#endif
+#if VA_LOG_LEVEL <= VA_LOG_LEVEL_WARN
+    #define VA_DLOG_WARN(fmt, ...) NTRNLVA_DLOG_EMIT("WARN", fmt, __VA_ARGS__)
+#else
+    #define VA_DLOG_WARN(fmt, ...) ((void)0)
+#endif
+#if VA_LOG_LEVEL <= VA_LOG_LEVEL_ERROR
+    #define VA_DLOG_ERROR(fmt, ...) NTRNLVA_DLOG_EMIT("ERROR", fmt, __VA_ARGS__)
+#else
+    #define VA_DLOG_ERROR(fmt, ...) ((void)0)
+#endif
+
+/* VA_DLOG(INFO, fmt, ...) is VA_DLOG_INFO(fmt, ...) */
+#define VA_DLOG(level, ...) NTRNLVA_CAT(VA_DLOG_, level)(__VA_ARGS__)
+
+#if defined(VA_DLOG_IMPLEMENTATION) || defined(TEST_VA_DLOG)
+#define NTRNLVA_RENDER_IMPLEMENTATION
+#include "va_internal.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if VA_DLOG_RING_SIZE & (VA_DLOG_RING_SIZE - 1)
+    #error "VA_DLOG_RING_SIZE must be a power of two"
+#endif
+
+/* Record: site pointer, payload size, payload, padded to 8 bytes */
+struct va_dlog_header {
+  const struct va_dlog_site *site;
+  size_t size;
+};
+
+struct va_dlog_ring {
+  _Atomic size_t head; /* written by the owning thread */
+  _Atomic size_t tail; /* written by the writer thread */
+  struct va_dlog_ring *next;
+  unsigned char data[VA_DLOG_RING_SIZE];
+};
+
+static _Atomic(struct va_dlog_ring *) va_dlog_rings_;
+static _Thread_local struct va_dlog_ring *va_dlog_ring_;
+/* The generation va_dlog_ring_ belongs to. va_dlog_stop() frees the rings,
+so a stale va_dlog_ring_ must be recognized without reading it. */
+static _Thread_local unsigned va_dlog_ring_gen_;
+static atomic_uint va_dlog_gen_;     /* odd while running */
+static atomic_int va_dlog_stopping_;
+static atomic_ulong va_dlog_passes_; /* writer passes completed */
+static FILE *va_dlog_out_;
+static pthread_t va_dlog_thread_;
+
+#define NTRNLVA_DLOG_ALIGN(n) (((n) + 7) & ~(size_t)7)
+
+static void va_dlog_copy_in(struct va_dlog_ring *r, size_t at, const void *src,
+                            size_t n) {
+  size_t off = at & (VA_DLOG_RING_SIZE - 1);
+  size_t first = n < VA_DLOG_RING_SIZE - off ? n : VA_DLOG_RING_SIZE - off;
+  memcpy(r->data + off, src, first);
+  memcpy(r->data, (const unsigned char *)src + first, n - first);
+}
+
+static void va_dlog_copy_out(const struct va_dlog_ring *r, size_t at,
+                             void *dst, size_t n) {
+  size_t off = at & (VA_DLOG_RING_SIZE - 1);
+  size_t first = n < VA_DLOG_RING_SIZE - off ? n : VA_DLOG_RING_SIZE - off;
+  memcpy(dst, r->data + off, first);
+  memcpy((unsigned char *)dst + first, r->data, n - first);
+}
+
+void va_dlog_push(const struct va_dlog_site *site, const unsigned char *rec,
+                  size_t size) {
+  unsigned gen = atomic_load_explicit(&va_dlog_gen_, memory_order_acquire);
+  struct va_dlog_ring *r = va_dlog_ring_;
+  struct va_dlog_header h;
+  size_t head, need;
+  if (!(gen & 1)) {
+    return;
+  }
+  if (!r || va_dlog_ring_gen_ != gen) {
+    r = (struct va_dlog_ring *)calloc(1, sizeof(*r));
+    if (!r) {
+      return;
+    }
+    r->next = atomic_load(&va_dlog_rings_);
+    while (!atomic_compare_exchange_weak(&va_dlog_rings_, &r->next, r)) {
+    }
+    va_dlog_ring_ = r;
+    va_dlog_ring_gen_ = gen;
+  }
+  h.site = site;
+  h.size = size;
+  need = NTRNLVA_DLOG_ALIGN(sizeof(h) + size);
+  head = atomic_load_explicit(&r->head, memory_order_relaxed);
+  while (VA_DLOG_RING_SIZE - (head - atomic_load_explicit(
+                                         &r->tail, memory_order_acquire)) <
+         need) {
+    sched_yield();
+  }
+  va_dlog_copy_in(r, head, &h, sizeof(h));
+  va_dlog_copy_in(r, head + sizeof(h), rec, size);
+  atomic_store_explicit(&r->head, head + need, memory_order_release);
+}
+
+unsigned long long va_dlog_scan(atomic_ullong *cache, const char *f) {
+  unsigned long long bits = 1ull << 63;
+  int arg = 0;
+  /* Arguments are counted as va_render takes them, '*' included */
+  while ((f = strchr(f, '%')) != NULL) {
+    if (*++f == '%') {
+      f++;
+      continue;
+    }
+    for (; *f && strchr("-+ #0123456789.*", *f); f++) {
+      arg += *f == '*';
+    }
+    while (*f && strchr("hljztLq", *f)) {
+      f++;
+    }
+    if (!*f) {
+      break;
+    }
+    if (*f++ == 's' && arg < 63) {
+      bits |= 1ull << arg;
+    }
+    arg++;
+  }
+  atomic_store_explicit(cache, bits, memory_order_relaxed);
+  return bits;
+}
+
+/* Hands a record's arguments to va_render as their tags say */
+struct va_dlog_reader {
+  const struct va_dlog_site *site;
+  const unsigned char *p;
+  int arg;
+};
+
+static int va_dlog_next(void *ctx, struct va_render_arg *a) {
+  struct va_dlog_reader *r = (struct va_dlog_reader *)ctx;
+  unsigned short slen;
+  if (r->arg >= r->site->nargs) {
+    return 0;
+  }
+  memset(a, 0, sizeof(*a));
+  switch (r->site->tags[r->arg++]) {
+  case VA_DLOG_INT:
+    memcpy(&a->i, r->p, sizeof(a->i));
+    r->p += sizeof(a->i);
+    a->u = (unsigned long long)a->i;
+    a->d = (double)a->i;
+    break;
+  case VA_DLOG_UINT:
+    memcpy(&a->u, r->p, sizeof(a->u));
+    r->p += sizeof(a->u);
+    a->i = (long long)a->u;
+    a->d = (double)a->u;
+    break;
+  case VA_DLOG_DOUBLE:
+    memcpy(&a->d, r->p, sizeof(a->d));
+    r->p += sizeof(a->d);
+    break;
+  case VA_DLOG_LDOUBLE:
+    memcpy(&a->ld, r->p, sizeof(a->ld));
+    r->p += sizeof(a->ld);
+    a->is_ldouble = 1;
+    break;
+  case VA_DLOG_STRING:
+    memcpy(&a->p, r->p, sizeof(a->p));
+    r->p += sizeof(a->p);
+    memcpy(&slen, r->p, sizeof(slen));
+    a->s = (const char *)r->p + sizeof(slen);
+    a->slen = slen;
+    r->p += sizeof(slen) + slen;
+    break;
+  default:
+    memcpy(&a->p, r->p, sizeof(a->p));
+    r->p += sizeof(a->p);
+    break;
+  }
+  return 1;
+}
+
+/* Appends one formatted record to out; returns the new length */
+static size_t va_dlog_render(char *out, size_t len, size_t cap,
+                             const struct va_dlog_site *site,
+                             const unsigned char *p) {
+  struct va_dlog_reader r;
+  r.site = site;
+  r.p = p;
+  r.arg = 0;
+  return va_render(out, len, cap, site->fmt, va_dlog_next, &r);
+}
+
+static void *va_dlog_writer(void *unused) {
+  static char batch[1 << 16];
+  unsigned char rec[VA_DLOG_MAX_RECORD];
+  (void)unused;
+  for (;;) {
+    int stopping = atomic_load(&va_dlog_stopping_);
+    size_t len = 0, end;
+    int any = 0;
+    struct va_dlog_ring *r;
+    for (r = atomic_load(&va_dlog_rings_); r; r = r->next) {
+      size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+      size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+      while (tail != head) {
+        struct va_dlog_header h;
+        va_dlog_copy_out(r, tail, &h, sizeof(h));
+        va_dlog_copy_out(r, tail + sizeof(h), rec, h.size);
+        tail += NTRNLVA_DLOG_ALIGN(sizeof(h) + h.size);
+        atomic_store_explicit(&r->tail, tail, memory_order_release);
+        end = va_dlog_render(batch, len, sizeof(batch), h.site, rec);
+        /* A record that reached the end of the batch may have been cut,
+        since a long literal or width is not bounded by the record size:
+        flush what came before it and render it again into an empty batch.
+        One longer than the whole batch is cut but keeps its '\n'. */
+        if (end == sizeof(batch) - 1 && len) {
+          fwrite(batch, 1, len, va_dlog_out_);
+          end = va_dlog_render(batch, 0, sizeof(batch), h.site, rec);
+        }
+        if (end == sizeof(batch) - 1) {
+          batch[end - 1] = '\n';
+        }
+        len = end;
+        any = 1;
+      }
+    }
+    if (len) {
+      fwrite(batch, 1, len, va_dlog_out_);
+    }
+    if (any) {
+      fflush(va_dlog_out_);
+    }
+    atomic_fetch_add(&va_dlog_passes_, 1);
+    if (!any) {
+      struct timespec idle = {0, 200000};
+      if (stopping) {
+        return NULL;
+      }
+      nanosleep(&idle, NULL);
+    }
+  }
+}
+
+int va_dlog_start(FILE *out) {
+  if (atomic_load(&va_dlog_gen_) & 1) {
+    return -1;
+  }
+  va_dlog_out_ = out;
+  atomic_store(&va_dlog_stopping_, 0);
+  if (pthread_create(&va_dlog_thread_, NULL, va_dlog_writer, NULL) != 0) {
+    return -1;
+  }
+  atomic_fetch_add(&va_dlog_gen_, 1);
+  return 0;
+}
+
+/* Waits until everything logged before the call has been written */
+void va_dlog_flush(void) {
+  struct va_dlog_ring *r;
+  unsigned long passes;
+  if (!(atomic_load(&va_dlog_gen_) & 1)) {
+    return;
+  }
+  for (r = atomic_load(&va_dlog_rings_); r; r = r->next) {
+    size_t head = atomic_load(&r->head);
+    while ((ptrdiff_t)(atomic_load(&r->tail) - head) < 0) {
+      sched_yield();
+    }
+  }
+  /* The pass that took the last record may still be writing */
+  passes = atomic_load(&va_dlog_passes_);
+  while (atomic_load(&va_dlog_passes_) - passes < 2) {
+    sched_yield();
+  }
+}
+
+void va_dlog_stop(void) {
+  struct va_dlog_ring *r;
+  if (!(atomic_load(&va_dlog_gen_) & 1)) {
+    return;
+  }
+  atomic_fetch_add(&va_dlog_gen_, 1);
+  atomic_store(&va_dlog_stopping_, 1);
+  pthread_join(va_dlog_thread_, NULL);
+  r = atomic_exchange(&va_dlog_rings_, NULL);
+  while (r) {
+    struct va_dlog_ring *next = r->next;
+    free(r);
+    r = next;
+  }
+}
+#endif /* VA_DLOG_IMPLEMENTATION */
+
+#ifdef TEST_VA_DLOG
+#define NTRNLVA_TEST
+#include "va_internal.h"
+
+static FILE *dlog_out;
+static long dlog_seen; /* bytes of dlog_out already checked */
+
+/* Flushes the logger and compares what it wrote since the last check */
+static void expect_written(const char *expected, int line) {
+  char buf[1024] = {0};
+  size_t len;
+  va_dlog_flush();
+  fseek(dlog_out, dlog_seen, SEEK_SET);
+  len = fread(buf, 1, sizeof(buf) - 1, dlog_out);
+  dlog_seen += (long)len;
+  fseek(dlog_out, 0, SEEK_END);
+  if (len != strlen(expected) || memcmp(buf, expected, len) != 0) {
+    printf("Test failed at line %d: wrote \"%s\" (expected \"%s\")\n", line,
+           buf, expected);
+    failed++;
+  } else {
+    passed++;
+  }
+}
+#define EXPECT_WRITTEN(expected) expect_written(expected, __LINE__)
+
+static void *dlog_thread(void *arg) {
+  int i;
+  for (i = 0; i < 1000; i++) {
+    VA_DLOG_INFO("t%d %d", *(int *)arg, i);
+  }
+  return NULL;
+}
+
+int main(void) {
+  const char *name = "alice";
+  char local[8] = "bob";
+  int x = 42;
+  pthread_t threads[4];
+  int ids[4] = {0, 1, 2, 3};
+  int i, counts[4] = {0};
+  char line[64];
+  char big[2000], cut[600];
+
+  dlog_out = tmpfile();
+  VA_DLOG_INFO("dropped while stopped");
+  va_dlog_start(dlog_out);
+
+  VA_DLOG_INFO("plain");
+  EXPECT_WRITTEN("[INFO] plain\n");
+  VA_DLOG_WARN("%d%% of %u", -5, 20u);
+  EXPECT_WRITTEN("[WARN] -5% of 20\n");
+  VA_DLOG(ERROR, "%s and %s", name, local);
+  local[0] = 'X'; /* strings are copied at the call */
+  EXPECT_WRITTEN("[ERROR] alice and bob\n");
+  VA_DLOG_INFO("%5.2f|%-4d|%x|%c|%.3s", 3.14159, 7, 255u, 'z', "abcdef");
+  EXPECT_WRITTEN("[INFO]  3.14|7   |ff|z|abc\n");
+  VA_DLOG_INFO("%*d|%ld|%llu|%Lg", 4, 1, 2L, 3ULL, (long double)0.5);
+  EXPECT_WRITTEN("[INFO]    1|2|3|0.5\n");
+  VA_DLOG_INFO("%d %d %d %d %d %d %d %d", 1, 2, 3, 4, 5, 6, 7, 8);
+  EXPECT_WRITTEN("[INFO] 1 2 3 4 5 6 7 8\n");
+  VA_DLOG_INFO("%.*s|%.*d|%*s", -1, "abc", -3, 7, -4, "l");
+  EXPECT_WRITTEN("[INFO] abc|7|l   \n");
+  /* Integers are converted to the format's type, as printf does */
+  VA_DLOG_WARN("x=%x u=%u o=%o", -1, -5, -8);
+  EXPECT_WRITTEN("[WARN] x=ffffffff u=4294967291 o=37777777770\n");
+  VA_DLOG_INFO("%hhx %hx %hhd %lx", (signed char)-1, (short)-2, 200, -1L);
+  sprintf(line, "[INFO] ff fffe -56 %lx\n", -1L);
+  EXPECT_WRITTEN(line);
+  /* A char * under %p is its address; only %s copies the bytes */
+  VA_DLOG_INFO("%p|%s|%p", local, name, (char *)NULL);
+  sprintf(line, "[INFO] %p|alice|%p\n", (void *)local, (void *)NULL);
+  EXPECT_WRITTEN(line);
+  /* %n takes its argument and writes nothing */
+  VA_DLOG_INFO("%d%n%d", 1, &i, 2);
+  EXPECT_WRITTEN("[INFO] 12\n");
+
+  /* The first string takes the room left for strings, the second gets none */
+  memset(big, 'a', sizeof(big) - 1);
+  big[sizeof(big) - 1] = '\0';
+  i = VA_DLOG_MAX_RECORD - VA_DLOG_MAX_ARGS * NTRNLVA_DLOG_SLOT -
+      (int)(sizeof(char *) + 2);
+  sprintf(cut, "[INFO] %.*s 1 \n", i, big);
+  VA_DLOG_INFO("%s %d %s", big, 1, big);
+  EXPECT_WRITTEN(cut);
+  /* A line wider than the room left in the batch is written whole */
+  for (i = 0; i < 3; i++) {
+    VA_DLOG_INFO("%*d", 30000, i);
+  }
+  va_dlog_flush();
+  fseek(dlog_out, dlog_seen, SEEK_SET);
+  for (i = 0; i < 3; i++) {
+    static char wide[30016];
+    size_t n = fgets(wide, sizeof(wide), dlog_out) ? strlen(wide) : 0;
+    EXPECT((int)n, 30008);
+    EXPECT(n > 1 ? wide[n - 2] : 0, '0' + i);
+  }
+  dlog_seen = ftell(dlog_out);
+  fseek(dlog_out, 0, SEEK_END);
+  VA_DLOG_DEBUG("%d", x++);
+  if (x != 42) {
+    printf("Test failed: a disabled level evaluated its arguments\n");
+    failed++;
+  }
+
+  for (i = 0; i < 4; i++) {
+    pthread_create(&threads[i], NULL, dlog_thread, &ids[i]);
+  }
+  for (i = 0; i < 4; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  va_dlog_stop();
+  VA_DLOG_INFO("dropped after stop");
+
+  /* Per thread, records keep their order */
+  rewind(dlog_out);
+  while (fgets(line, sizeof(line), dlog_out)) {
+    int t, n;
+    if (sscanf(line, "[INFO] t%d %d", &t, &n) == 2 && t >= 0 && t < 4) {
+      if (n != counts[t]++) {
+        printf("Test failed: thread %d wrote %d out of order\n", t, n);
+        failed++;
+      }
+    }
+  }
+  for (i = 0; i < 4; i++) {
+    if (counts[i] != 1000) {
+      printf("Test failed: thread %d wrote %d of 1000 records\n", i,
+             counts[i]);
+      failed++;
+    } else {
+      passed++;
+    }
+  }
+
+  /* The rings of the first run were freed; each thread starts a new one */
+  va_dlog_start(dlog_out);
+  fseek(dlog_out, 0, SEEK_END);
+  dlog_seen = ftell(dlog_out);
+  VA_DLOG_INFO("restarted %d", 2);
+  EXPECT_WRITTEN("[INFO] restarted 2\n");
+  va_dlog_stop();
+
+  return test_report();
+}
+#endif /* TEST_VA_DLOG */
+
+#endif /* VA_DLOG_H */
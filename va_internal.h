@@ -0,0 +1,263 @@
+/* SPDX-License-Identifier: CC0-1.0 */
+
+/*
+Internals shared by va_log.h, va_dlog.h, va_trace.h, va_assert.h and
+va_print.h, and by their test suites. Not an interface of its own.
+Licensed as CC0 1.0 Universal.
+To view a copy of this license,
+visit https://creativecommons.org/publicdomain/zero/1.0/
+
+Two parts are defined only on request, once per translation unit, by
+defining the macro and including this header again:
+  NTRNLVA_RENDER_IMPLEMENTATION  va_render(), printf-style formatting of
+                                 arguments handed over one at a time
+  NTRNLVA_TEST                   the counters, EXPECT and test_report() of
+                                 the TEST_VA_* suites
+*/
+
+#ifndef VA_INTERNAL_H
+#define VA_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "va_opt.h"
+
+/* Gives fmt printf's -Wformat check against the arguments. The call sits
+behind 0 &&, so it is never executed and emits no code. */
+#define NTRNLVA_FORMAT_CHECK(fmt, ...)                                         \
+  ((void)(0 && printf(fmt VA_OPT((__VA_ARGS__), ,) __VA_ARGS__)))
+
+/* Thread-local storage in C11 and in C++ */
+#ifdef __cplusplus
+    #define NTRNLVA_TLS thread_local
+#else
+    #define NTRNLVA_TLS _Thread_local
+#endif
+
+/* Picks one of i, u, d, ld, s and p by the type of x: signed and unsigned
+integers, double (float too), long double, strings and other pointers */
+#define NTRNLVA_GENERIC_KIND(x, i, u, d, ld, s, p)                             \
+  _Generic((x),                                                                \
+      _Bool: u, char: i, signed char: i, unsigned char: u, short: i,           \
+      unsigned short: u, int: i, unsigned: u, long: i, unsigned long: u,       \
+      long long: i, unsigned long long: u, float: d, double: d,                \
+      long double: ld, char *: s, const char *: s, default: p)
+
+/* Bytes of the integer that the length modifier of n characters at f names,
+as printf converts the argument to it. No modifier names int. */
+static inline size_t va_int_size(const char *f, size_t n) {
+  if (!n) {
+    return sizeof(int);
+  }
+  switch (*f) {
+  case 'h':
+    return n > 1 ? sizeof(char) : sizeof(short);
+  case 'l':
+    return n > 1 ? sizeof(long long) : sizeof(long);
+  case 'j':
+    return sizeof(intmax_t);
+  case 'z':
+    return sizeof(size_t);
+  case 't':
+    return sizeof(ptrdiff_t);
+  default: /* L and q */
+    return sizeof(long long);
+  }
+}
+
+/* v cut to size bytes, sign-extended back when is_signed, so a negative
+int under %x is ffffffff and not sixteen digits */
+static inline unsigned long long va_int_cut(unsigned long long v, size_t size,
+                                            int is_signed) {
+  unsigned long long top;
+  if (size >= sizeof(v)) {
+    return v;
+  }
+  top = 1ull << (size * 8 - 1);
+  v &= (top << 1) - 1;
+  return is_signed ? (v ^ top) - top : v;
+}
+
+/* One argument for va_render, in every form a conversion may ask for */
+struct va_render_arg {
+  long long i;
+  unsigned long long u;
+  double d;
+  long double ld;
+  int is_ldouble; /* floating conversions use ld */
+  const char *s;  /* NULL unless the argument is a string */
+  size_t slen;    /* bytes at s, which need not be terminated */
+  const void *p;
+};
+
+/* Fills arg with the next argument; returns 0 when none is left */
+typedef int (*va_render_next)(void *ctx, struct va_render_arg *arg);
+
+#endif /* VA_INTERNAL_H */
+
+#if defined(NTRNLVA_RENDER_IMPLEMENTATION) && !defined(NTRNLVA_RENDER_DEFINED)
+#define NTRNLVA_RENDER_DEFINED
+#include <stdlib.h>
+#include <string.h>
+
+/* Appends fmt rendered with the arguments from next to out; returns the new
+length, at most cap - 1. Each conversion is rebuilt with the length modifier
+of the argument's stored type and handed to snprintf. An integer is first
+cut to the size of the format's own modifier, as printf would convert it.
+%n consumes its argument and writes nothing; conversions without an
+argument are dropped. */
+static size_t va_render(char *out, size_t len, size_t cap, const char *f,
+                        va_render_next next, void *ctx) {
+  while (*f && len + 1 < cap) {
+    char spec[48];
+    size_t n = 0;
+    size_t size;
+    int wrote = 0;
+    const char *length;
+    struct va_render_arg a;
+    if (*f != '%' || f[1] == '%') {
+      out[len++] = *f;
+      f += *f == '%' ? 2 : 1;
+      continue;
+    }
+    /* The bound leaves room for a '*' value and the conversion's suffix */
+    spec[n++] = *f++;
+    while (*f && strchr("-+ #0123456789.*", *f) && n < sizeof(spec) - 24) {
+      if (*f == '*') {
+        /* A missing or negative precision is taken as omitted */
+        int have = next(ctx, &a);
+        if (spec[n - 1] == '.' && (!have || a.i < 0)) {
+          n--;
+        } else if (have) {
+          n += (size_t)sprintf(spec + n, "%d", (int)a.i);
+        }
+        f++;
+        continue;
+      }
+      spec[n++] = *f++;
+    }
+    length = f;
+    while (*f && strchr("hljztLq", *f)) {
+      f++;
+    }
+    if (!*f) {
+      break;
+    }
+    if (!next(ctx, &a) || *f == 'n') {
+      f++;
+      continue;
+    }
+    switch (*f) {
+    case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+      size = va_int_size(length, (size_t)(f - length));
+      spec[n++] = 'l';
+      spec[n++] = 'l';
+      spec[n++] = *f;
+      spec[n] = '\0';
+      wrote = strchr("di", *f)
+                  ? snprintf(out + len, cap - len, spec,
+                             (long long)va_int_cut(a.u, size, 1))
+                  : snprintf(out + len, cap - len, spec,
+                             va_int_cut(a.u, size, 0));
+      break;
+    case 'c':
+      spec[n++] = 'c';
+      spec[n] = '\0';
+      wrote = snprintf(out + len, cap - len, spec, (int)a.i);
+      break;
+    case 's':
+      if (!a.s) {
+        a.s = "(null)";
+        a.slen = 6;
+      }
+      /* The precision bounds the bytes, which are passed as "%.*s" */
+      if (memchr(spec, '.', n)) {
+        int prec = atoi((char *)memchr(spec, '.', n) + 1);
+        a.slen = prec >= 0 && (size_t)prec < a.slen ? (size_t)prec : a.slen;
+        n = (size_t)((char *)memchr(spec, '.', n) - spec);
+      }
+      memcpy(spec + n, ".*s", 4);
+      wrote = snprintf(out + len, cap - len, spec, (int)a.slen, a.s);
+      break;
+    case 'p':
+      spec[n++] = 'p';
+      spec[n] = '\0';
+      wrote = snprintf(out + len, cap - len, spec, (void *)a.p);
+      break;
+    default:
+      if (a.is_ldouble) {
+        spec[n++] = 'L';
+        spec[n++] = *f;
+        spec[n] = '\0';
+        wrote = snprintf(out + len, cap - len, spec, a.ld);
+      } else {
+        spec[n++] = *f;
+        spec[n] = '\0';
+        wrote = snprintf(out + len, cap - len, spec, a.d);
+      }
+      break;
+    }
+    f++;
+    if (wrote > 0) {
+      len += (size_t)wrote < cap - len ? (size_t)wrote : cap - len - 1;
+    }
+  }
+  return len;
+}
+#endif /* NTRNLVA_RENDER_IMPLEMENTATION */
+
+#if defined(NTRNLVA_TEST) && !defined(NTRNLVA_TEST_DEFINED)
+#define NTRNLVA_TEST_DEFINED
+#include <string.h>
+
+static int passed = 0;
+static int failed = 0;
+static int evaluated = 0;
+
+/* Counts its evaluations, for the tests that arguments run once or never */
+static inline int side_effect(void) { return ++evaluated; }
+
+#define EXPECT(test, expected)                                                 \
+  do {                                                                         \
+    int result = (test);                                                       \
+    if (result != (expected)) {                                                \
+      printf("Test failed: %s (expected %d, got %d)\n", #test, expected,       \
+             result);                                                          \
+      failed++;                                                                \
+    } else {                                                                   \
+      passed++;                                                                \
+    }                                                                          \
+  } while (0)
+
+/* Runs stmt with stream pointing at a temporary file and compares what it
+wrote with expected */
+#define EXPECT_OUTPUT(stream, stmt, expected)                                  \
+  do {                                                                         \
+    char buf[256] = {0};                                                       \
+    size_t len;                                                                \
+    stream = tmpfile();                                                        \
+    stmt;                                                                      \
+    rewind(stream);                                                            \
+    len = fread(buf, 1, sizeof(buf) - 1, stream);                              \
+    fclose(stream);                                                            \
+    if (len != strlen(expected) || memcmp(buf, expected, len) != 0) {          \
+      printf("Test failed: %s wrote \"%s\" (expected \"%s\")\n", #stmt, buf,   \
+             expected);                                                        \
+      failed++;                                                                \
+    } else {                                                                   \
+      passed++;                                                                \
+    }                                                                          \
+  } while (0)
+
+/* Prints the totals; returns main's exit status */
+static int test_report(void) {
+  printf("Tests passed: %d\n", passed);
+  printf("Tests failed: %d\n", failed);
+  if (failed == 0) {
+    printf("All tests passed!\n");
+  }
+  return !!failed;
+}
+#endif /* NTRNLVA_TEST */
@@ -0,0 +1,142 @@
+/* SPDX-License-Identifier: CC0-1.0 */
+
+#ifndef VA_LOG_H
+#define VA_LOG_H
+
+/*
+Leveled logging on top of va_opt.h.
+Licensed as CC0 1.0 Universal.
+To view a copy of this license,
+visit https://creativecommons.org/publicdomain/zero/1.0/
+
+EXAMPLE USAGE:
+
+#define VA_LOG_LEVEL VA_LOG_LEVEL_DEBUG
+#include "va_log.h"
+
+VA_LOG_INFO("listening");            // fwrite("[INFO] listening\n", 1, 17, ..)
+VA_LOG_WARN("retry %d of %d", i, n); // fprintf(.., "[WARN] retry %d of %d\n",
+                                     //         i, n)
+VA_LOG_TRACE("state %d", dump());    // nothing; dump() is not called
+VA_LOG(ERROR, "lost %s", name);      // same as VA_LOG_ERROR
+
+LEVELS:
+  TRACE, DEBUG, INFO, WARN and ERROR, from most to least verbose. Define
+  VA_LOG_LEVEL before including this header to one of VA_LOG_LEVEL_TRACE ..
+  VA_LOG_LEVEL_ERROR, or VA_LOG_LEVEL_OFF (default VA_LOG_LEVEL_INFO). Calls
+  below it expand to ((void)0): the arguments are not evaluated and the format
+  string is not emitted.
+
+OUTPUT:
+  Each call writes one line, "[LEVEL] " fmt "\n", to VA_LOG_STREAM (default
+  stderr). fmt must be a string literal, and it is checked like printf's
+  even without arguments. With no arguments after fmt, VA_ISEMPTY routes the
+  call to fwrite with the length taken from sizeof, like fputs, so no format
+  string is parsed at run time. A format with a '%' goes to fprintf instead,
+  so "%%" prints '%' with or without arguments; the choice folds away when
+  optimizing. Otherwise the call is one fprintf. Every call is a void
+  expression.
+
+RUN TESTS:
+    cc -x c -DTEST_VA_LOG va_log.h -o va_log_test && ./va_log_test
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "va_internal.h"
+
+#define VA_LOG_LEVEL_TRACE 0
+#define VA_LOG_LEVEL_DEBUG 1
+#define VA_LOG_LEVEL_INFO 2
+#define VA_LOG_LEVEL_WARN 3
+#define VA_LOG_LEVEL_ERROR 4
+#define VA_LOG_LEVEL_OFF 5
+
+#ifndef VA_LOG_LEVEL
+    #define VA_LOG_LEVEL VA_LOG_LEVEL_INFO
+#endif
+#ifndef VA_LOG_STREAM
+    #define VA_LOG_STREAM stderr
+#endif
+
+/* VA_ISEMPTY picks fwrite (1) or fprintf (0); the empty case gets a
+trailing empty argument, which EMIT_1 ignores */
+#define NTRNLVA_LOG_EMIT(tag, fmt, ...)                                        \
+  NTRNLVA_CAT(NTRNLVA_LOG_EMIT_, VA_ISEMPTY(__VA_ARGS__))                      \
+  ("[" tag "] " fmt "\n", __VA_ARGS__)
+#define NTRNLVA_LOG_EMIT_0(line, ...)                                          \
+  ((void)fprintf(VA_LOG_STREAM, line, __VA_ARGS__))
+/* Without arguments, a line with no '%' is written as is. strchr on the
+literal is folded when optimizing, as is fprintf without conversions. */
+#define NTRNLVA_LOG_EMIT_1(line, ...)                                          \
+  (NTRNLVA_FORMAT_CHECK(line, ),                                               \
+   strchr(line, '%') ? (void)fprintf(VA_LOG_STREAM, line)                      \
+                     : (void)fwrite(line, 1, sizeof(line) - 1, VA_LOG_STREAM))
+
+#if VA_LOG_LEVEL <= VA_LOG_LEVEL_TRACE
+    #define VA_LOG_TRACE(fmt, ...) NTRNLVA_LOG_EMIT("TRACE", fmt, __VA_ARGS__)
+#else
+    #define VA_LOG_TRACE(fmt, ...) ((void)0)
+#endif
+#if VA_LOG_LEVEL <= VA_LOG_LEVEL_DEBUG
+    #define VA_LOG_DEBUG(fmt, ...) NTRNLVA_LOG_EMIT("DEBUG", fmt, __VA_ARGS__)
+#else
+    #define VA_LOG_DEBUG(fmt, ...) ((void)0)
+#endif
+#if VA_LOG_LEVEL <= VA_LOG_LEVEL_INFO
+    #define VA_LOG_INFO(fmt, ...) NTRNLVA_LOG_EMIT("INFO", fmt, __VA_ARGS__)
+#else
+    #define VA_LOG_INFO(fmt, ...) ((void)0)
+#endif
+#if VA_LOG_LEVEL <= VA_LOG_LEVEL_WARN
+    #define VA_LOG_WARN(fmt, ...) NTRNLVA_LOG_EMIT("WARN", fmt, __VA_ARGS__)
+#else
+    #define VA_LOG_WARN(fmt, ...) ((void)0)
+#endif
+#if VA_LOG_LEVEL <= VA_LOG_LEVEL_ERROR
+    #define VA_LOG_ERROR(fmt, ...) NTRNLVA_LOG_EMIT("ERROR", fmt, __VA_ARGS__)
+#else
+    #define VA_LOG_ERROR(fmt, ...) ((void)0)
+#endif
+
+/* VA_LOG(INFO, fmt, ...) is VA_LOG_INFO(fmt, ...) */
+#define VA_LOG(level, ...) NTRNLVA_CAT(VA_LOG_, level)(__VA_ARGS__)
+
+#ifdef TEST_VA_LOG
+#define NTRNLVA_TEST
+#include "va_internal.h"
+
+/* The calls write to log_stream, which EXPECT_LOG points at a temporary
+file */
+static FILE *log_stream;
+#undef VA_LOG_STREAM
+#define VA_LOG_STREAM log_stream
+#define EXPECT_LOG(stmt, expected) EXPECT_OUTPUT(log_stream, stmt, expected)
+
+int main(void) {
+  EXPECT_LOG(VA_LOG_INFO("hello"), "[INFO] hello\n");
+  EXPECT_LOG(VA_LOG_INFO("%d + %d", 1, 2), "[INFO] 1 + 2\n");
+  EXPECT_LOG(VA_LOG_WARN("%s", "a, b"), "[WARN] a, b\n");
+  EXPECT_LOG(VA_LOG_ERROR("(%d)", (1 + 2)), "[ERROR] (3)\n");
+  EXPECT_LOG(VA_LOG(ERROR, "code %d", 7), "[ERROR] code 7\n");
+  EXPECT_LOG(VA_LOG(WARN, "plain"), "[WARN] plain\n");
+  /* "%%" prints '%' with or without arguments */
+  EXPECT_LOG(VA_LOG_INFO("100%%"), "[INFO] 100%\n");
+  EXPECT_LOG(VA_LOG_INFO("%d%%", 100), "[INFO] 100%\n");
+
+  /* Below VA_LOG_LEVEL nothing is written or evaluated */
+  EXPECT_LOG(VA_LOG_DEBUG("%d", side_effect()), "");
+  EXPECT_LOG(VA_LOG_TRACE("%d", side_effect()), "");
+  EXPECT(evaluated, 0);
+  EXPECT_LOG(VA_LOG_INFO("%d", side_effect()), "[INFO] 1\n");
+  EXPECT(evaluated, 1);
+
+  /* Every call is a void expression */
+  EXPECT_LOG((VA_LOG_INFO("x"), VA_LOG_DEBUG("y")), "[INFO] x\n");
+
+  return test_report();
+}
+#endif /* TEST_VA_LOG */
+
+#endif /* VA_LOG_H */
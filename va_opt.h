@@ -52,6 +52,20 @@ CHOOSE IMPLEMENTATIONS:
   - VA_OPT_USE_GNU
   - VA_OPT_USE_MSVC
   - VA_OPT_USE_C99
+  Without one, a va_opt_config.h written by `make configure` pins the choice
+  for the toolchains it has entries for (define VA_OPT_NO_CONFIG to ignore it).
+
+CANONICAL OUTPUT:
+  Define VA_OPT_CANONICAL to make the native implementation expand VA_OPT,
+  VA_NOPT, VA_OPT_ELSE, VA_IF_EMPTY_ELSE and VA_WITH_EMPTINESS through the
+  same macros as the others, so `cc -E` output is byte-identical whichever
+  implementation is selected (for preprocessed-output compiler caches). This
+  gives up the shorter native expansion.
+
+MINIMAL OUTPUT:
+  Define VA_OPT_MINIMAL_OUTPUT to have VA_NARGS fold counts above 64 into
+  "(base+rest)" instead of "(64 + 64 + ... + rest)", at the cost of a 256-entry
+  lookup table. Every other macro already expands to the fewest tokens.
 
 IMPLEMENTATION NOTES:
     Native __VA_OPT__ support or comma elision compiler extensions are detected 
@@ -86,6 +100,15 @@ IMPLEMENTATION NOTES:
     #define NTRNLVA_IMPL NTRNLVA_IMPL_C99
 #endif
 
+/* Use the result of `make configure` (tools/configure.py) if it has an entry
+for this compiler and language mode; otherwise detect below */
+#if !defined(NTRNLVA_IMPL) && !defined(VA_OPT_NO_CONFIG) &&                     \
+    defined(__has_include)
+    #if __has_include("va_opt_config.h")
+        #include "va_opt_config.h"
+    #endif
+#endif
+
 #define NTRNLVA_EXPAND(...) __VA_ARGS__
 #define NTRNLVA_SEL3_I(a, b, c, ...) c
 #define NTRNLVA_SEL3(...) NTRNLVA_EXPAND(NTRNLVA_SEL3_I(__VA_ARGS__))
@@ -124,7 +147,9 @@ IMPLEMENTATION NOTES:
 #endif /* Auto-select implementation */
 #endif /* NTRNLVA_IMPL */
 
-#ifdef _MSVC_TRADITIONAL
+#ifdef NTRNLVA_MSVC_TRADITIONAL
+    /* Pinned by va_opt_config.h */
+#elif defined(_MSVC_TRADITIONAL)
     #define NTRNLVA_MSVC_TRADITIONAL _MSVC_TRADITIONAL
 #else
     #define NTRNLVA_MSVC_TRADITIONAL 0
@@ -194,19 +219,15 @@ IMPLEMENTATION NOTES:
 
 /* ISEMPTY IMPLEMENTATIONS */
 #if NTRNLVA_IMPL == NTRNLVA_IMPL_NATIVE
-    #define NTRNLVA_ISEMPTY_I0 1
-    #define NTRNLVA_ISEMPTY_I01 0
-    #define NTRNLVA_ISEMPTY_I(x) NTRNLVA_PRIMITIVE_CAT(NTRNLVA_ISEMPTY_I0, x)
-    #define VA_ISEMPTY(...) NTRNLVA_ISEMPTY_I(__VA_OPT__(1))
-    
-    #define NTRNLVA_NOTEMPTY_I0 0
-    #define NTRNLVA_NOTEMPTY_I01 1
-    #define NTRNLVA_NOTEMPTY_I(x) NTRNLVA_PRIMITIVE_CAT(NTRNLVA_NOTEMPTY_I0, x)
-    #define VA_NOTEMPTY(...) NTRNLVA_NOTEMPTY_I(__VA_OPT__(1))
+    /* __VA_OPT__ shifts the answer into second place */
+    #define VA_ISEMPTY(...) NTRNLVA_SEL2_I(__VA_OPT__(, ) 0, 1, )
+    #define VA_NOTEMPTY(...) NTRNLVA_SEL2_I(__VA_OPT__(, ) 1, 0, )
 #elif NTRNLVA_IMPL == NTRNLVA_IMPL_GNU
-    #define NTRNLVA_ISEMPTY_I(_0, _1, _2, ...) NTRNLVA_CHECK_SENTINEL(_2)
-    #define NTRNLVA_ISEMPTY_INDIRECT(...)                                                    \
-        NTRNLVA_ISEMPTY_I(,##__VA_ARGS__, 0, NTRNLVA_SENTINEL_)
+    /* Arguments push the sentinel out of first place. They land in the
+    unused variadic part, so ISEMPTY_I never rescans them. */
+    #define NTRNLVA_ISEMPTY_I(x, ...) NTRNLVA_CHECK_SENTINEL(x)
+    #define NTRNLVA_ISEMPTY_INDIRECT(...)                                      \
+        NTRNLVA_ISEMPTY_I(,##__VA_ARGS__ NTRNLVA_SENTINEL_, )
     #define VA_ISEMPTY(...) NTRNLVA_ISEMPTY_INDIRECT(__VA_ARGS__)
     #define VA_NOTEMPTY(...) NTRNLVA_COMPL(VA_ISEMPTY(__VA_ARGS__))
 #elif NTRNLVA_IMPL == NTRNLVA_IMPL_MSVC
@@ -217,10 +238,20 @@ IMPLEMENTATION NOTES:
     #define VA_NOTEMPTY(...) NTRNLVA_COMPL(VA_ISEMPTY(__VA_ARGS__))
 #elif NTRNLVA_IMPL == NTRNLVA_IMPL_C99
 
-    #define NTRNLVA_ISEMPTY_I(...)                                              \
-      NTRNLVA_AND(NTRNLVA_ISEMPTY_BASE(NTRNLVA_SEL1(__VA_ARGS__)))             \
-      (NTRNLVA_CHECK_SENTINEL(NTRNLVA_SEL2(__VA_ARGS__)))
+    /* The first argument is run through the four P99 probes below one at a
+    time, most decisive first, and the first probe that rules out emptiness
+    stops the chain. Only an empty first argument reaches the last check,
+    which tests that nothing follows it. */
+    #define NTRNLVA_ISEMPTY_I(x, ...)                                          \
+      NTRNLVA_ISEMPTY_CAT(                                                     \
+          NTRNLVA_ISEMPTY_P3_,                                                 \
+          NTRNLVA_HAS_COMMA(NTRNLVA_TRIGGER_PARENTHESIS_ x()))(x, __VA_ARGS__)
+#if NTRNLVA_MSVC_TRADITIONAL
+    #define VA_ISEMPTY(...)                                                    \
+      NTRNLVA_EXPAND(NTRNLVA_ISEMPTY_I(__VA_ARGS__, NTRNLVA_SENTINEL_))
+#else
     #define VA_ISEMPTY(...) NTRNLVA_ISEMPTY_I(__VA_ARGS__, NTRNLVA_SENTINEL_)
+#endif /* NTRNLVA_MSVC_TRADITIONAL check */
     #define VA_NOTEMPTY(...) NTRNLVA_COMPL(VA_ISEMPTY(__VA_ARGS__))
 
 /* START OF APACHE LICENSED P99 CODE ******************************************/
@@ -257,31 +288,30 @@ IMPLEMENTATION NOTES:
 #endif /* NTRNLVA_MSVC_TRADITIONAL check */
 #define NTRNLVA_TRIGGER_PARENTHESIS_(...) ,
 
-#define NTRNLVA_ISEMPTY_BASE(...)                                              \
-  NTRNLVA_ISEMPTY_BASE_I(/* test if there is just one argument, eventually an  \
-                            empty one */                                       \
-                         NTRNLVA_HAS_COMMA(                                    \
-                             __VA_ARGS__), /* test if                          \
-                                              NTRNLVA_TRIGGER_PARENTHESIS_     \
-                                              together with the argument adds  \
-                                              a comma */                       \
-                         NTRNLVA_HAS_COMMA(                                    \
-                             NTRNLVA_TRIGGER_PARENTHESIS_                      \
-                                 __VA_ARGS__), /* test if the argument         \
-                                                  together with a parenthesis  \
-                                                  adds a comma */              \
-                         NTRNLVA_HAS_COMMA(__VA_ARGS__(                        \
-                             /*empty*/)), /* test if placing it between        \
-                                             NTRNLVA_TRIGGER_PARENTHESIS_ and  \
-                                             the parenthesis adds a comma */   \
-                         NTRNLVA_HAS_COMMA(                                    \
-                             NTRNLVA_TRIGGER_PARENTHESIS_ __VA_ARGS__(         \
-                                 /*empty*/)))
-
-#define NTRNLVA_PASTE5(_0, _1, _2, _3, _4) _0##_1##_2##_3##_4
-#define NTRNLVA_ISEMPTY_BASE_I(_0, _1, _2, _3)                                 \
-  NTRNLVA_HAS_COMMA(NTRNLVA_PASTE5(NTRNLVA_IS_EMPTY_CASE_, _0, _1, _2, _3))
-#define NTRNLVA_IS_EMPTY_CASE_0001 ,
+#define NTRNLVA_ISEMPTY_CAT(a, b) NTRNLVA_ISEMPTY_CAT_I(a, b)
+#define NTRNLVA_ISEMPTY_CAT_I(a, b) a##b
+
+/* test if placing the argument between NTRNLVA_TRIGGER_PARENTHESIS_ and the
+parenthesis adds a comma; if not, it is not empty */
+#define NTRNLVA_ISEMPTY_P3_0(x, ...) 0
+#define NTRNLVA_ISEMPTY_P3_1(x, ...)                                           \
+  NTRNLVA_ISEMPTY_CAT(NTRNLVA_ISEMPTY_P1_,                                     \
+                      NTRNLVA_HAS_COMMA(NTRNLVA_TRIGGER_PARENTHESIS_ x))       \
+  (x, __VA_ARGS__)
+/* test if NTRNLVA_TRIGGER_PARENTHESIS_ together with the argument adds a
+comma */
+#define NTRNLVA_ISEMPTY_P1_1(x, ...) 0
+#define NTRNLVA_ISEMPTY_P1_0(x, ...)                                           \
+  NTRNLVA_ISEMPTY_CAT(NTRNLVA_ISEMPTY_P0_, NTRNLVA_HAS_COMMA(x))(x, __VA_ARGS__)
+/* test if there is just one argument, eventually an empty one */
+#define NTRNLVA_ISEMPTY_P0_1(x, ...) 0
+#define NTRNLVA_ISEMPTY_P0_0(x, ...)                                           \
+  NTRNLVA_ISEMPTY_CAT(NTRNLVA_ISEMPTY_P2_, NTRNLVA_HAS_COMMA(x()))             \
+  (x, __VA_ARGS__)
+/* test if the argument together with a parenthesis adds a comma */
+#define NTRNLVA_ISEMPTY_P2_1(x, ...) 0
+#define NTRNLVA_ISEMPTY_P2_0(x, ...)                                           \
+  NTRNLVA_CHECK_SENTINEL(NTRNLVA_SEL1(__VA_ARGS__))
 
 #endif /* End of VA_ISEMPTY implementations */
 
@@ -326,31 +356,712 @@ argument in the list passed to VA_OPT or VA_ISEMPTY */
   X(0, a, b, c, d, e)                                                          \
   X(0, (void), b, c, d)
 
+/* Expands to "(), EATER3 ()", which a second scan would call again */
+#define RESCAN_TEST_CASES                                                      \
+  X(0, EATER3 () EATER3 EATER2 ())
+
 #define ISEMPTY_TEST_CASES                                                     \
   SINGLE_TEST_CASES                                                            \
-  VARIADIC_TEST_CASES
+  VARIADIC_TEST_CASES                                                          \
+  RESCAN_TEST_CASES
 
 #endif /* TEST_VA_OPT */
 /* END OF APACHE LICENSED P99 CODE ********************************************/
 
 /* VA_OPT IMPLEMENTATIONS */
+#if NTRNLVA_IMPL == NTRNLVA_IMPL_NATIVE && !defined(VA_OPT_CANONICAL)
+    #define NTRNLVA_NATIVE_PATH 1
+#else
+    #define NTRNLVA_NATIVE_PATH 0
+#endif
 #define NTRNLVA_OPT_IMPL(opt, ...)                                             \
   NTRNLVA_CAT(NTRNLVA_OPT_IMPL_, opt)(__VA_ARGS__)
 #define NTRNLVA_OPT_IMPL_0(...) __VA_ARGS__
 #define NTRNLVA_OPT_IMPL_1(...)
 
-#if NTRNLVA_IMPL != NTRNLVA_IMPL_NATIVE
+#if !NTRNLVA_NATIVE_PATH
     #define VA_OPT(args, ...)                                                  \
       NTRNLVA_OPT_IMPL(VA_ISEMPTY(NTRNLVA_UP(args)), __VA_ARGS__)
+    #define VA_NOPT(args, ...)                                                 \
+      NTRNLVA_OPT_IMPL(VA_NOTEMPTY(NTRNLVA_UP(args)), __VA_ARGS__)
+#else
+    /* `NTRNLVA_OPT_N args` runs __VA_OPT__ on the parenthesized payload and
+    leaves a macro name for the branch that follows it: NTRNLVA_UP_I keeps the
+    branch, NTRNLVA_EMPTY drops it. The branch is prescanned only once, as an
+    argument of VA_OPT. */
+    #define NTRNLVA_OPT_N(...) NTRNLVA_EMPTY __VA_OPT__(() NTRNLVA_UP_I)
+    #define NTRNLVA_NOPT_N(...) NTRNLVA_UP_I __VA_OPT__(() NTRNLVA_EMPTY)
+    #define VA_OPT(args, ...) NTRNLVA_OPT_N args(__VA_ARGS__)
+    #define VA_NOPT(args, ...) NTRNLVA_NOPT_N args(__VA_ARGS__)
+#endif /* NTRNLVA_NATIVE_PATH */
+
+/* Single-evaluation if/else: the emptiness test runs once per call site instead
+of once for VA_OPT and again for VA_NOPT. The first branch is a single macro
+argument; the variadic branch may contain commas. */
+#define NTRNLVA_ELSE_IMPL(opt, first, ...)                                     \
+  NTRNLVA_CAT(NTRNLVA_ELSE_IMPL_, opt)(first, __VA_ARGS__)
+#define NTRNLVA_ELSE_IMPL_0(first, ...) first
+#define NTRNLVA_ELSE_IMPL_1(first, ...) __VA_ARGS__
+#if !NTRNLVA_NATIVE_PATH
+    #define VA_OPT_ELSE(args, then, ...)                                       \
+      NTRNLVA_ELSE_IMPL(VA_ISEMPTY(NTRNLVA_UP(args)), then, __VA_ARGS__)
+    #define VA_IF_EMPTY_ELSE(args, then, ...)                                  \
+      NTRNLVA_ELSE_IMPL(VA_NOTEMPTY(NTRNLVA_UP(args)), then, __VA_ARGS__)
+#else
+    /* As NTRNLVA_OPT_N, with `(, )` emptying the selector that is not used */
+    #define NTRNLVA_ELSE_N(...)                                                \
+      NTRNLVA_ELSE_IMPL_1 __VA_OPT__((, ) NTRNLVA_ELSE_IMPL_0)
+    #define NTRNLVA_IF_EMPTY_N(...)                                            \
+      NTRNLVA_ELSE_IMPL_0 __VA_OPT__((, ) NTRNLVA_ELSE_IMPL_1)
+    #define VA_OPT_ELSE(args, then, ...)                                       \
+      NTRNLVA_ELSE_N args(then, __VA_ARGS__)
+    #define VA_IF_EMPTY_ELSE(args, then, ...)                                  \
+      NTRNLVA_IF_EMPTY_N args(then, __VA_ARGS__)
+#endif /* NTRNLVA_NATIVE_PATH */
+
+/* Continuation passing: test args once and call macro(isempty, ...) with a
+literal 0/1. The *_BIT forms branch on that result without re-testing. */
+#if NTRNLVA_MSVC_TRADITIONAL
+    #define NTRNLVA_WITH_I(macro, bit, ...)                                    \
+      NTRNLVA_EXPAND(macro(bit, __VA_ARGS__))
+#else
+    #define NTRNLVA_WITH_I(macro, bit, ...) macro(bit, __VA_ARGS__)
+#endif /* NTRNLVA_MSVC_TRADITIONAL check */
+#if !NTRNLVA_NATIVE_PATH
+    #define VA_WITH_EMPTINESS(args, macro, ...)                                \
+      NTRNLVA_WITH_I(macro, VA_ISEMPTY(NTRNLVA_UP(args)), __VA_ARGS__)
+#else
+    #define VA_WITH_EMPTINESS(args, macro, ...)                                \
+      NTRNLVA_WITH_I(macro, VA_ISEMPTY args, __VA_ARGS__)
+#endif /* NTRNLVA_NATIVE_PATH */
+#define VA_OPT_BIT(isempty, ...) NTRNLVA_OPT_IMPL(isempty, __VA_ARGS__)
+#define VA_NOPT_BIT(isempty, ...)                                              \
+  NTRNLVA_OPT_IMPL(NTRNLVA_COMPL(isempty), __VA_ARGS__)
+#define VA_OPT_ELSE_BIT(isempty, then, ...)                                    \
+  NTRNLVA_ELSE_IMPL(isempty, then, __VA_ARGS__)
+
+/* Argument counting. The list is matched against a 64-entry table in one pass.
+Table entries look like NTRNLVA_SENTINEL_, so NTRNLVA_CHECK_SENTINEL tells a
+table hit (at most 64 arguments) from a user argument in 65th position. A hit
+is applied to the list: "n NTRNLVA_EMPTY" discards it, and the single-argument
+entry runs VA_NOTEMPTY so an empty list counts as 0.
+Longer lists strip 64-argument chunks, driven by a doubling chain of
+NTRNLVA_NARGS_L<k> levels, so nesting depth is logarithmic in the chunk count
+and no EVAL-style blanket rescans are needed. Capacity is 256 chunks, 16384
+arguments; the MSVC traditional preprocessor is limited to the 64-argument
+table. Counts above 64 expand to a parenthesized constant expression. */
+#define NTRNLVA_NARGS_SEL65_I(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11,    \
+                              _12, _13, _14, _15, _16, _17, _18, _19, _20,     \
+                              _21, _22, _23, _24, _25, _26, _27, _28, _29,     \
+                              _30, _31, _32, _33, _34, _35, _36, _37, _38,     \
+                              _39, _40, _41, _42, _43, _44, _45, _46, _47,     \
+                              _48, _49, _50, _51, _52, _53, _54, _55, _56,     \
+                              _57, _58, _59, _60, _61, _62, _63, _64, n, ...) n
+#define NTRNLVA_NARGS_DROP64_I(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11,   \
+                               _12, _13, _14, _15, _16, _17, _18, _19, _20,    \
+                               _21, _22, _23, _24, _25, _26, _27, _28, _29,    \
+                               _30, _31, _32, _33, _34, _35, _36, _37, _38,    \
+                               _39, _40, _41, _42, _43, _44, _45, _46, _47,    \
+                               _48, _49, _50, _51, _52, _53, _54, _55, _56,    \
+                               _57, _58, _59, _60, _61, _62, _63, _64, ...)    \
+  __VA_ARGS__
+#define NTRNLVA_NARGS_TABLE_                                                   \
+  ()()(64 NTRNLVA_EMPTY), ()()(63 NTRNLVA_EMPTY), ()()(62 NTRNLVA_EMPTY),      \
+  ()()(61 NTRNLVA_EMPTY), ()()(60 NTRNLVA_EMPTY), ()()(59 NTRNLVA_EMPTY),      \
+  ()()(58 NTRNLVA_EMPTY), ()()(57 NTRNLVA_EMPTY), ()()(56 NTRNLVA_EMPTY),      \
+  ()()(55 NTRNLVA_EMPTY), ()()(54 NTRNLVA_EMPTY), ()()(53 NTRNLVA_EMPTY),      \
+  ()()(52 NTRNLVA_EMPTY), ()()(51 NTRNLVA_EMPTY), ()()(50 NTRNLVA_EMPTY),      \
+  ()()(49 NTRNLVA_EMPTY), ()()(48 NTRNLVA_EMPTY), ()()(47 NTRNLVA_EMPTY),      \
+  ()()(46 NTRNLVA_EMPTY), ()()(45 NTRNLVA_EMPTY), ()()(44 NTRNLVA_EMPTY),      \
+  ()()(43 NTRNLVA_EMPTY), ()()(42 NTRNLVA_EMPTY), ()()(41 NTRNLVA_EMPTY),      \
+  ()()(40 NTRNLVA_EMPTY), ()()(39 NTRNLVA_EMPTY), ()()(38 NTRNLVA_EMPTY),      \
+  ()()(37 NTRNLVA_EMPTY), ()()(36 NTRNLVA_EMPTY), ()()(35 NTRNLVA_EMPTY),      \
+  ()()(34 NTRNLVA_EMPTY), ()()(33 NTRNLVA_EMPTY), ()()(32 NTRNLVA_EMPTY),      \
+  ()()(31 NTRNLVA_EMPTY), ()()(30 NTRNLVA_EMPTY), ()()(29 NTRNLVA_EMPTY),      \
+  ()()(28 NTRNLVA_EMPTY), ()()(27 NTRNLVA_EMPTY), ()()(26 NTRNLVA_EMPTY),      \
+  ()()(25 NTRNLVA_EMPTY), ()()(24 NTRNLVA_EMPTY), ()()(23 NTRNLVA_EMPTY),      \
+  ()()(22 NTRNLVA_EMPTY), ()()(21 NTRNLVA_EMPTY), ()()(20 NTRNLVA_EMPTY),      \
+  ()()(19 NTRNLVA_EMPTY), ()()(18 NTRNLVA_EMPTY), ()()(17 NTRNLVA_EMPTY),      \
+  ()()(16 NTRNLVA_EMPTY), ()()(15 NTRNLVA_EMPTY), ()()(14 NTRNLVA_EMPTY),      \
+  ()()(13 NTRNLVA_EMPTY), ()()(12 NTRNLVA_EMPTY), ()()(11 NTRNLVA_EMPTY),      \
+  ()()(10 NTRNLVA_EMPTY), ()()(9 NTRNLVA_EMPTY), ()()(8 NTRNLVA_EMPTY),        \
+  ()()(7 NTRNLVA_EMPTY), ()()(6 NTRNLVA_EMPTY), ()()(5 NTRNLVA_EMPTY),         \
+  ()()(4 NTRNLVA_EMPTY), ()()(3 NTRNLVA_EMPTY), ()()(2 NTRNLVA_EMPTY),         \
+  ()()(VA_NOTEMPTY), ~
+#define NTRNLVA_NARGS_GET2(...) __VA_ARGS__
+#define NTRNLVA_NARGS_GET1(...) NTRNLVA_NARGS_GET2
+#define NTRNLVA_NARGS_GET(...) NTRNLVA_NARGS_GET1
+
+#if NTRNLVA_MSVC_TRADITIONAL
+    #define NTRNLVA_NARGS_SEL65(...)                                           \
+      NTRNLVA_EXPAND(NTRNLVA_NARGS_SEL65_I(__VA_ARGS__))
+    #define NTRNLVA_NARGS_DROP64(...)                                          \
+      NTRNLVA_EXPAND(NTRNLVA_NARGS_DROP64_I(__VA_ARGS__))
+#else
+    #define NTRNLVA_NARGS_SEL65(...) NTRNLVA_NARGS_SEL65_I(__VA_ARGS__)
+    #define NTRNLVA_NARGS_DROP64(...) NTRNLVA_NARGS_DROP64_I(__VA_ARGS__)
+#endif /* NTRNLVA_MSVC_TRADITIONAL check */
+#define NTRNLVA_NARGS_LOOKUP(...)                                              \
+  NTRNLVA_NARGS_SEL65(__VA_ARGS__, NTRNLVA_NARGS_TABLE_)
+
+/* Chunk state is (done, acc, rest...). acc collects "64 +" per stripped chunk
+(or, with VA_OPT_MINIMAL_OUTPUT, the running multiple of 64); the final step
+replaces it with the total and sets done. Each L<k>_0 runs
+L<k-1> twice, the inner result reaching the outer one through the variadic
+NTRNLVA_NARGS_I<k-1> so it is split back into parameters. */
+#define NTRNLVA_NARGS_STEP(hit, acc, ...)                                      \
+  NTRNLVA_CAT(NTRNLVA_NARGS_STEP_, NTRNLVA_CHECK_SENTINEL(hit))                \
+  (hit, acc, __VA_ARGS__)
+#ifdef VA_OPT_MINIMAL_OUTPUT
+    /* acc is a single literal, looked up from the previous one */
+    #define NTRNLVA_NARGS_STEP_0(hit, acc, ...)                                \
+      0, NTRNLVA_NARGS_ADD64_##acc, NTRNLVA_NARGS_DROP64(__VA_ARGS__)
+    #define NTRNLVA_NARGS_STEP_1(hit, acc, ...)                                \
+      1, (acc+NTRNLVA_NARGS_GET hit(__VA_ARGS__)),
+    /* BEGIN GENERATED BY tools/gen_tables.py: nargs_add64 */
+    #define NTRNLVA_NARGS_ADD64_ 64
+    #define NTRNLVA_NARGS_ADD64_64 128
+    #define NTRNLVA_NARGS_ADD64_128 192
+    #define NTRNLVA_NARGS_ADD64_192 256
+    #define NTRNLVA_NARGS_ADD64_256 320
+    #define NTRNLVA_NARGS_ADD64_320 384
+    #define NTRNLVA_NARGS_ADD64_384 448
+    #define NTRNLVA_NARGS_ADD64_448 512
+    #define NTRNLVA_NARGS_ADD64_512 576
+    #define NTRNLVA_NARGS_ADD64_576 640
+    #define NTRNLVA_NARGS_ADD64_640 704
+    #define NTRNLVA_NARGS_ADD64_704 768
+    #define NTRNLVA_NARGS_ADD64_768 832
+    #define NTRNLVA_NARGS_ADD64_832 896
+    #define NTRNLVA_NARGS_ADD64_896 960
+    #define NTRNLVA_NARGS_ADD64_960 1024
+    #define NTRNLVA_NARGS_ADD64_1024 1088
+    #define NTRNLVA_NARGS_ADD64_1088 1152
+    #define NTRNLVA_NARGS_ADD64_1152 1216
+    #define NTRNLVA_NARGS_ADD64_1216 1280
+    #define NTRNLVA_NARGS_ADD64_1280 1344
+    #define NTRNLVA_NARGS_ADD64_1344 1408
+    #define NTRNLVA_NARGS_ADD64_1408 1472
+    #define NTRNLVA_NARGS_ADD64_1472 1536
+    #define NTRNLVA_NARGS_ADD64_1536 1600
+    #define NTRNLVA_NARGS_ADD64_1600 1664
+    #define NTRNLVA_NARGS_ADD64_1664 1728
+    #define NTRNLVA_NARGS_ADD64_1728 1792
+    #define NTRNLVA_NARGS_ADD64_1792 1856
+    #define NTRNLVA_NARGS_ADD64_1856 1920
+    #define NTRNLVA_NARGS_ADD64_1920 1984
+    #define NTRNLVA_NARGS_ADD64_1984 2048
+    #define NTRNLVA_NARGS_ADD64_2048 2112
+    #define NTRNLVA_NARGS_ADD64_2112 2176
+    #define NTRNLVA_NARGS_ADD64_2176 2240
+    #define NTRNLVA_NARGS_ADD64_2240 2304
+    #define NTRNLVA_NARGS_ADD64_2304 2368
+    #define NTRNLVA_NARGS_ADD64_2368 2432
+    #define NTRNLVA_NARGS_ADD64_2432 2496
+    #define NTRNLVA_NARGS_ADD64_2496 2560
+    #define NTRNLVA_NARGS_ADD64_2560 2624
+    #define NTRNLVA_NARGS_ADD64_2624 2688
+    #define NTRNLVA_NARGS_ADD64_2688 2752
+    #define NTRNLVA_NARGS_ADD64_2752 2816
+    #define NTRNLVA_NARGS_ADD64_2816 2880
+    #define NTRNLVA_NARGS_ADD64_2880 2944
+    #define NTRNLVA_NARGS_ADD64_2944 3008
+    #define NTRNLVA_NARGS_ADD64_3008 3072
+    #define NTRNLVA_NARGS_ADD64_3072 3136
+    #define NTRNLVA_NARGS_ADD64_3136 3200
+    #define NTRNLVA_NARGS_ADD64_3200 3264
+    #define NTRNLVA_NARGS_ADD64_3264 3328
+    #define NTRNLVA_NARGS_ADD64_3328 3392
+    #define NTRNLVA_NARGS_ADD64_3392 3456
+    #define NTRNLVA_NARGS_ADD64_3456 3520
+    #define NTRNLVA_NARGS_ADD64_3520 3584
+    #define NTRNLVA_NARGS_ADD64_3584 3648
+    #define NTRNLVA_NARGS_ADD64_3648 3712
+    #define NTRNLVA_NARGS_ADD64_3712 3776
+    #define NTRNLVA_NARGS_ADD64_3776 3840
+    #define NTRNLVA_NARGS_ADD64_3840 3904
+    #define NTRNLVA_NARGS_ADD64_3904 3968
+    #define NTRNLVA_NARGS_ADD64_3968 4032
+    #define NTRNLVA_NARGS_ADD64_4032 4096
+    #define NTRNLVA_NARGS_ADD64_4096 4160
+    #define NTRNLVA_NARGS_ADD64_4160 4224
+    #define NTRNLVA_NARGS_ADD64_4224 4288
+    #define NTRNLVA_NARGS_ADD64_4288 4352
+    #define NTRNLVA_NARGS_ADD64_4352 4416
+    #define NTRNLVA_NARGS_ADD64_4416 4480
+    #define NTRNLVA_NARGS_ADD64_4480 4544
+    #define NTRNLVA_NARGS_ADD64_4544 4608
+    #define NTRNLVA_NARGS_ADD64_4608 4672
+    #define NTRNLVA_NARGS_ADD64_4672 4736
+    #define NTRNLVA_NARGS_ADD64_4736 4800
+    #define NTRNLVA_NARGS_ADD64_4800 4864
+    #define NTRNLVA_NARGS_ADD64_4864 4928
+    #define NTRNLVA_NARGS_ADD64_4928 4992
+    #define NTRNLVA_NARGS_ADD64_4992 5056
+    #define NTRNLVA_NARGS_ADD64_5056 5120
+    #define NTRNLVA_NARGS_ADD64_5120 5184
+    #define NTRNLVA_NARGS_ADD64_5184 5248
+    #define NTRNLVA_NARGS_ADD64_5248 5312
+    #define NTRNLVA_NARGS_ADD64_5312 5376
+    #define NTRNLVA_NARGS_ADD64_5376 5440
+    #define NTRNLVA_NARGS_ADD64_5440 5504
+    #define NTRNLVA_NARGS_ADD64_5504 5568
+    #define NTRNLVA_NARGS_ADD64_5568 5632
+    #define NTRNLVA_NARGS_ADD64_5632 5696
+    #define NTRNLVA_NARGS_ADD64_5696 5760
+    #define NTRNLVA_NARGS_ADD64_5760 5824
+    #define NTRNLVA_NARGS_ADD64_5824 5888
+    #define NTRNLVA_NARGS_ADD64_5888 5952
+    #define NTRNLVA_NARGS_ADD64_5952 6016
+    #define NTRNLVA_NARGS_ADD64_6016 6080
+    #define NTRNLVA_NARGS_ADD64_6080 6144
+    #define NTRNLVA_NARGS_ADD64_6144 6208
+    #define NTRNLVA_NARGS_ADD64_6208 6272
+    #define NTRNLVA_NARGS_ADD64_6272 6336
+    #define NTRNLVA_NARGS_ADD64_6336 6400
+    #define NTRNLVA_NARGS_ADD64_6400 6464
+    #define NTRNLVA_NARGS_ADD64_6464 6528
+    #define NTRNLVA_NARGS_ADD64_6528 6592
+    #define NTRNLVA_NARGS_ADD64_6592 6656
+    #define NTRNLVA_NARGS_ADD64_6656 6720
+    #define NTRNLVA_NARGS_ADD64_6720 6784
+    #define NTRNLVA_NARGS_ADD64_6784 6848
+    #define NTRNLVA_NARGS_ADD64_6848 6912
+    #define NTRNLVA_NARGS_ADD64_6912 6976
+    #define NTRNLVA_NARGS_ADD64_6976 7040
+    #define NTRNLVA_NARGS_ADD64_7040 7104
+    #define NTRNLVA_NARGS_ADD64_7104 7168
+    #define NTRNLVA_NARGS_ADD64_7168 7232
+    #define NTRNLVA_NARGS_ADD64_7232 7296
+    #define NTRNLVA_NARGS_ADD64_7296 7360
+    #define NTRNLVA_NARGS_ADD64_7360 7424
+    #define NTRNLVA_NARGS_ADD64_7424 7488
+    #define NTRNLVA_NARGS_ADD64_7488 7552
+    #define NTRNLVA_NARGS_ADD64_7552 7616
+    #define NTRNLVA_NARGS_ADD64_7616 7680
+    #define NTRNLVA_NARGS_ADD64_7680 7744
+    #define NTRNLVA_NARGS_ADD64_7744 7808
+    #define NTRNLVA_NARGS_ADD64_7808 7872
+    #define NTRNLVA_NARGS_ADD64_7872 7936
+    #define NTRNLVA_NARGS_ADD64_7936 8000
+    #define NTRNLVA_NARGS_ADD64_8000 8064
+    #define NTRNLVA_NARGS_ADD64_8064 8128
+    #define NTRNLVA_NARGS_ADD64_8128 8192
+    #define NTRNLVA_NARGS_ADD64_8192 8256
+    #define NTRNLVA_NARGS_ADD64_8256 8320
+    #define NTRNLVA_NARGS_ADD64_8320 8384
+    #define NTRNLVA_NARGS_ADD64_8384 8448
+    #define NTRNLVA_NARGS_ADD64_8448 8512
+    #define NTRNLVA_NARGS_ADD64_8512 8576
+    #define NTRNLVA_NARGS_ADD64_8576 8640
+    #define NTRNLVA_NARGS_ADD64_8640 8704
+    #define NTRNLVA_NARGS_ADD64_8704 8768
+    #define NTRNLVA_NARGS_ADD64_8768 8832
+    #define NTRNLVA_NARGS_ADD64_8832 8896
+    #define NTRNLVA_NARGS_ADD64_8896 8960
+    #define NTRNLVA_NARGS_ADD64_8960 9024
+    #define NTRNLVA_NARGS_ADD64_9024 9088
+    #define NTRNLVA_NARGS_ADD64_9088 9152
+    #define NTRNLVA_NARGS_ADD64_9152 9216
+    #define NTRNLVA_NARGS_ADD64_9216 9280
+    #define NTRNLVA_NARGS_ADD64_9280 9344
+    #define NTRNLVA_NARGS_ADD64_9344 9408
+    #define NTRNLVA_NARGS_ADD64_9408 9472
+    #define NTRNLVA_NARGS_ADD64_9472 9536
+    #define NTRNLVA_NARGS_ADD64_9536 9600
+    #define NTRNLVA_NARGS_ADD64_9600 9664
+    #define NTRNLVA_NARGS_ADD64_9664 9728
+    #define NTRNLVA_NARGS_ADD64_9728 9792
+    #define NTRNLVA_NARGS_ADD64_9792 9856
+    #define NTRNLVA_NARGS_ADD64_9856 9920
+    #define NTRNLVA_NARGS_ADD64_9920 9984
+    #define NTRNLVA_NARGS_ADD64_9984 10048
+    #define NTRNLVA_NARGS_ADD64_10048 10112
+    #define NTRNLVA_NARGS_ADD64_10112 10176
+    #define NTRNLVA_NARGS_ADD64_10176 10240
+    #define NTRNLVA_NARGS_ADD64_10240 10304
+    #define NTRNLVA_NARGS_ADD64_10304 10368
+    #define NTRNLVA_NARGS_ADD64_10368 10432
+    #define NTRNLVA_NARGS_ADD64_10432 10496
+    #define NTRNLVA_NARGS_ADD64_10496 10560
+    #define NTRNLVA_NARGS_ADD64_10560 10624
+    #define NTRNLVA_NARGS_ADD64_10624 10688
+    #define NTRNLVA_NARGS_ADD64_10688 10752
+    #define NTRNLVA_NARGS_ADD64_10752 10816
+    #define NTRNLVA_NARGS_ADD64_10816 10880
+    #define NTRNLVA_NARGS_ADD64_10880 10944
+    #define NTRNLVA_NARGS_ADD64_10944 11008
+    #define NTRNLVA_NARGS_ADD64_11008 11072
+    #define NTRNLVA_NARGS_ADD64_11072 11136
+    #define NTRNLVA_NARGS_ADD64_11136 11200
+    #define NTRNLVA_NARGS_ADD64_11200 11264
+    #define NTRNLVA_NARGS_ADD64_11264 11328
+    #define NTRNLVA_NARGS_ADD64_11328 11392
+    #define NTRNLVA_NARGS_ADD64_11392 11456
+    #define NTRNLVA_NARGS_ADD64_11456 11520
+    #define NTRNLVA_NARGS_ADD64_11520 11584
+    #define NTRNLVA_NARGS_ADD64_11584 11648
+    #define NTRNLVA_NARGS_ADD64_11648 11712
+    #define NTRNLVA_NARGS_ADD64_11712 11776
+    #define NTRNLVA_NARGS_ADD64_11776 11840
+    #define NTRNLVA_NARGS_ADD64_11840 11904
+    #define NTRNLVA_NARGS_ADD64_11904 11968
+    #define NTRNLVA_NARGS_ADD64_11968 12032
+    #define NTRNLVA_NARGS_ADD64_12032 12096
+    #define NTRNLVA_NARGS_ADD64_12096 12160
+    #define NTRNLVA_NARGS_ADD64_12160 12224
+    #define NTRNLVA_NARGS_ADD64_12224 12288
+    #define NTRNLVA_NARGS_ADD64_12288 12352
+    #define NTRNLVA_NARGS_ADD64_12352 12416
+    #define NTRNLVA_NARGS_ADD64_12416 12480
+    #define NTRNLVA_NARGS_ADD64_12480 12544
+    #define NTRNLVA_NARGS_ADD64_12544 12608
+    #define NTRNLVA_NARGS_ADD64_12608 12672
+    #define NTRNLVA_NARGS_ADD64_12672 12736
+    #define NTRNLVA_NARGS_ADD64_12736 12800
+    #define NTRNLVA_NARGS_ADD64_12800 12864
+    #define NTRNLVA_NARGS_ADD64_12864 12928
+    #define NTRNLVA_NARGS_ADD64_12928 12992
+    #define NTRNLVA_NARGS_ADD64_12992 13056
+    #define NTRNLVA_NARGS_ADD64_13056 13120
+    #define NTRNLVA_NARGS_ADD64_13120 13184
+    #define NTRNLVA_NARGS_ADD64_13184 13248
+    #define NTRNLVA_NARGS_ADD64_13248 13312
+    #define NTRNLVA_NARGS_ADD64_13312 13376
+    #define NTRNLVA_NARGS_ADD64_13376 13440
+    #define NTRNLVA_NARGS_ADD64_13440 13504
+    #define NTRNLVA_NARGS_ADD64_13504 13568
+    #define NTRNLVA_NARGS_ADD64_13568 13632
+    #define NTRNLVA_NARGS_ADD64_13632 13696
+    #define NTRNLVA_NARGS_ADD64_13696 13760
+    #define NTRNLVA_NARGS_ADD64_13760 13824
+    #define NTRNLVA_NARGS_ADD64_13824 13888
+    #define NTRNLVA_NARGS_ADD64_13888 13952
+    #define NTRNLVA_NARGS_ADD64_13952 14016
+    #define NTRNLVA_NARGS_ADD64_14016 14080
+    #define NTRNLVA_NARGS_ADD64_14080 14144
+    #define NTRNLVA_NARGS_ADD64_14144 14208
+    #define NTRNLVA_NARGS_ADD64_14208 14272
+    #define NTRNLVA_NARGS_ADD64_14272 14336
+    #define NTRNLVA_NARGS_ADD64_14336 14400
+    #define NTRNLVA_NARGS_ADD64_14400 14464
+    #define NTRNLVA_NARGS_ADD64_14464 14528
+    #define NTRNLVA_NARGS_ADD64_14528 14592
+    #define NTRNLVA_NARGS_ADD64_14592 14656
+    #define NTRNLVA_NARGS_ADD64_14656 14720
+    #define NTRNLVA_NARGS_ADD64_14720 14784
+    #define NTRNLVA_NARGS_ADD64_14784 14848
+    #define NTRNLVA_NARGS_ADD64_14848 14912
+    #define NTRNLVA_NARGS_ADD64_14912 14976
+    #define NTRNLVA_NARGS_ADD64_14976 15040
+    #define NTRNLVA_NARGS_ADD64_15040 15104
+    #define NTRNLVA_NARGS_ADD64_15104 15168
+    #define NTRNLVA_NARGS_ADD64_15168 15232
+    #define NTRNLVA_NARGS_ADD64_15232 15296
+    #define NTRNLVA_NARGS_ADD64_15296 15360
+    #define NTRNLVA_NARGS_ADD64_15360 15424
+    #define NTRNLVA_NARGS_ADD64_15424 15488
+    #define NTRNLVA_NARGS_ADD64_15488 15552
+    #define NTRNLVA_NARGS_ADD64_15552 15616
+    #define NTRNLVA_NARGS_ADD64_15616 15680
+    #define NTRNLVA_NARGS_ADD64_15680 15744
+    #define NTRNLVA_NARGS_ADD64_15744 15808
+    #define NTRNLVA_NARGS_ADD64_15808 15872
+    #define NTRNLVA_NARGS_ADD64_15872 15936
+    #define NTRNLVA_NARGS_ADD64_15936 16000
+    #define NTRNLVA_NARGS_ADD64_16000 16064
+    #define NTRNLVA_NARGS_ADD64_16064 16128
+    #define NTRNLVA_NARGS_ADD64_16128 16192
+    #define NTRNLVA_NARGS_ADD64_16192 16256
+    #define NTRNLVA_NARGS_ADD64_16256 16320
+    #define NTRNLVA_NARGS_ADD64_16320 16384
+    /* END GENERATED: nargs_add64 */
+#else
+    #define NTRNLVA_NARGS_STEP_0(hit, acc, ...)                                \
+      0, acc 64 +, NTRNLVA_NARGS_DROP64(__VA_ARGS__)
+    #define NTRNLVA_NARGS_STEP_1(hit, acc, ...)                                \
+      1, (acc NTRNLVA_NARGS_GET hit(__VA_ARGS__)),
+#endif /* VA_OPT_MINIMAL_OUTPUT */
+#define NTRNLVA_NARGS_L0(done, acc, ...)                                       \
+  NTRNLVA_PRIMITIVE_CAT(NTRNLVA_NARGS_L0_, done)(acc, __VA_ARGS__)
+#define NTRNLVA_NARGS_L0_0(acc, ...)                                           \
+  NTRNLVA_NARGS_STEP(NTRNLVA_NARGS_LOOKUP(__VA_ARGS__), acc, __VA_ARGS__)
+#define NTRNLVA_NARGS_L0_1(acc, ...) 1, acc,
+#define NTRNLVA_NARGS_I0(...) NTRNLVA_NARGS_L0(__VA_ARGS__)
+#define NTRNLVA_NARGS_L1(done, acc, ...)                                       \
+  NTRNLVA_PRIMITIVE_CAT(NTRNLVA_NARGS_L1_, done)(acc, __VA_ARGS__)
+#define NTRNLVA_NARGS_L1_0(acc, ...)                                           \
+  NTRNLVA_NARGS_I0(NTRNLVA_NARGS_L0(0, acc, __VA_ARGS__))
+#define NTRNLVA_NARGS_L1_1(acc, ...) 1, acc,
+#define NTRNLVA_NARGS_I1(...) NTRNLVA_NARGS_L1(__VA_ARGS__)
+#define NTRNLVA_NARGS_L2(done, acc, ...)                                       \
+  NTRNLVA_PRIMITIVE_CAT(NTRNLVA_NARGS_L2_, done)(acc, __VA_ARGS__)
+#define NTRNLVA_NARGS_L2_0(acc, ...)                                           \
+  NTRNLVA_NARGS_I1(NTRNLVA_NARGS_L1(0, acc, __VA_ARGS__))
+#define NTRNLVA_NARGS_L2_1(acc, ...) 1, acc,
+#define NTRNLVA_NARGS_I2(...) NTRNLVA_NARGS_L2(__VA_ARGS__)
+#define NTRNLVA_NARGS_L3(done, acc, ...)                                       \
+  NTRNLVA_PRIMITIVE_CAT(NTRNLVA_NARGS_L3_, done)(acc, __VA_ARGS__)
+#define NTRNLVA_NARGS_L3_0(acc, ...)                                           \
+  NTRNLVA_NARGS_I2(NTRNLVA_NARGS_L2(0, acc, __VA_ARGS__))
+#define NTRNLVA_NARGS_L3_1(acc, ...) 1, acc,
+#define NTRNLVA_NARGS_I3(...) NTRNLVA_NARGS_L3(__VA_ARGS__)
+#define NTRNLVA_NARGS_L4(done, acc, ...)                                       \
+  NTRNLVA_PRIMITIVE_CAT(NTRNLVA_NARGS_L4_, done)(acc, __VA_ARGS__)
+#define NTRNLVA_NARGS_L4_0(acc, ...)                                           \
+  NTRNLVA_NARGS_I3(NTRNLVA_NARGS_L3(0, acc, __VA_ARGS__))
+#define NTRNLVA_NARGS_L4_1(acc, ...) 1, acc,
+#define NTRNLVA_NARGS_I4(...) NTRNLVA_NARGS_L4(__VA_ARGS__)
+#define NTRNLVA_NARGS_L5(done, acc, ...)                                       \
+  NTRNLVA_PRIMITIVE_CAT(NTRNLVA_NARGS_L5_, done)(acc, __VA_ARGS__)
+#define NTRNLVA_NARGS_L5_0(acc, ...)                                           \
+  NTRNLVA_NARGS_I4(NTRNLVA_NARGS_L4(0, acc, __VA_ARGS__))
+#define NTRNLVA_NARGS_L5_1(acc, ...) 1, acc,
+#define NTRNLVA_NARGS_I5(...) NTRNLVA_NARGS_L5(__VA_ARGS__)
+#define NTRNLVA_NARGS_L6(done, acc, ...)                                       \
+  NTRNLVA_PRIMITIVE_CAT(NTRNLVA_NARGS_L6_, done)(acc, __VA_ARGS__)
+#define NTRNLVA_NARGS_L6_0(acc, ...)                                           \
+  NTRNLVA_NARGS_I5(NTRNLVA_NARGS_L5(0, acc, __VA_ARGS__))
+#define NTRNLVA_NARGS_L6_1(acc, ...) 1, acc,
+#define NTRNLVA_NARGS_I6(...) NTRNLVA_NARGS_L6(__VA_ARGS__)
+#define NTRNLVA_NARGS_L7(done, acc, ...)                                       \
+  NTRNLVA_PRIMITIVE_CAT(NTRNLVA_NARGS_L7_, done)(acc, __VA_ARGS__)
+#define NTRNLVA_NARGS_L7_0(acc, ...)                                           \
+  NTRNLVA_NARGS_I6(NTRNLVA_NARGS_L6(0, acc, __VA_ARGS__))
+#define NTRNLVA_NARGS_L7_1(acc, ...) 1, acc,
+#define NTRNLVA_NARGS_I7(...) NTRNLVA_NARGS_L7(__VA_ARGS__)
+#define NTRNLVA_NARGS_L8(done, acc, ...)                                       \
+  NTRNLVA_PRIMITIVE_CAT(NTRNLVA_NARGS_L8_, done)(acc, __VA_ARGS__)
+#define NTRNLVA_NARGS_L8_0(acc, ...)                                           \
+  NTRNLVA_NARGS_I7(NTRNLVA_NARGS_L7(0, acc, __VA_ARGS__))
+#define NTRNLVA_NARGS_L8_1(acc, ...) 1, acc,
+
+#define NTRNLVA_NARGS_RESULT(done, n, ...)                                     \
+  NTRNLVA_PRIMITIVE_CAT(NTRNLVA_NARGS_RESULT_, done)(n)
+#define NTRNLVA_NARGS_RESULT_0(n) VA_NARGS_capacity_exceeded
+#define NTRNLVA_NARGS_RESULT_1(n) n
+#define NTRNLVA_NARGS_RESULT_I(...) NTRNLVA_NARGS_RESULT(__VA_ARGS__)
+
+#define NTRNLVA_NARGS_I(hit, ...)                                              \
+  NTRNLVA_CAT(NTRNLVA_NARGS_FIT_, NTRNLVA_CHECK_SENTINEL(hit))(hit, __VA_ARGS__)
+#if NTRNLVA_MSVC_TRADITIONAL
+    /* The chunk chain relies on __VA_ARGS__ splitting into named parameters */
+    #define NTRNLVA_NARGS_FIT_0(hit, ...) VA_NARGS_capacity_exceeded
+#else
+    #define NTRNLVA_NARGS_FIT_0(hit, ...)                                      \
+      NTRNLVA_NARGS_RESULT_I(NTRNLVA_NARGS_L8(0, , __VA_ARGS__))
+#endif /* NTRNLVA_MSVC_TRADITIONAL check */
+#define NTRNLVA_NARGS_FIT_1(hit, ...) NTRNLVA_NARGS_GET hit(__VA_ARGS__)
+#define VA_NARGS(...)                                                          \
+  NTRNLVA_NARGS_I(NTRNLVA_NARGS_LOOKUP(__VA_ARGS__), __VA_ARGS__)
+
+/* Arity dispatch: prefix##N(args), N from the VA_NARGS table. N must be one
+token, so longer lists expand to VA_OVERLOAD_capacity_exceeded. */
+#define NTRNLVA_OVERLOAD_I(hit, prefix, ...)                                   \
+  NTRNLVA_CAT(NTRNLVA_OVERLOAD_FIT_, NTRNLVA_CHECK_SENTINEL(hit))              \
+  (hit, prefix, __VA_ARGS__)
+#define NTRNLVA_OVERLOAD_FIT_0(hit, prefix, ...) VA_OVERLOAD_capacity_exceeded
+#define NTRNLVA_OVERLOAD_FIT_1(hit, prefix, ...)                               \
+  NTRNLVA_CAT(prefix, NTRNLVA_NARGS_GET hit(__VA_ARGS__))(__VA_ARGS__)
+#define VA_OVERLOAD(prefix, ...)                                               \
+  NTRNLVA_OVERLOAD_I(NTRNLVA_NARGS_LOOKUP(__VA_ARGS__), prefix, __VA_ARGS__)
+
+/* For-each. NTRNLVA_EACH_C<n> handles ten elements with their indices written
+out and NTRNLVA_EACH_F<t> the last t < 10 in one flat step. NTRNLVA_EACH_NEXT
+chooses between them with one table lookup, as VA_NARGS does, so an N element
+list costs about N/10 steps and no VA_ISEMPTY test per element. The list carries
+a trailing empty argument so a step's variadic parameter is never left without
+one. VA_OPT_MAX_EACH (default 64, at most 128) sets how many chunks are defined:
+every list of up to VA_OPT_MAX_EACH elements works, and longer ones expand to
+VA_FOR_EACH_capacity_exceeded once the chunks run out. The steps are not
+reentrant: the applied macro cannot itself use VA_FOR_EACH or VA_MAP.
+The chunk and tail macros are generated by tools/gen_tables.py. */
+#ifndef VA_OPT_MAX_EACH
+    #define VA_OPT_MAX_EACH 64
+#endif
+#if VA_OPT_MAX_EACH > 128
+    #error "VA_OPT_MAX_EACH must not exceed 128"
+#endif
+
+#define NTRNLVA_EACH_CALL(m, i, x) m(x)
+#define NTRNLVA_EACH_CALL_I(m, i, x) m(i, x)
+#define NTRNLVA_EACH_COMMA() ,
+
+/* Every step is called through NTRNLVA_EACH_GO, the one place the MSVC
+traditional preprocessor needs its extra rescan to split __VA_ARGS__ */
+#if NTRNLVA_MSVC_TRADITIONAL
+    #define NTRNLVA_EACH_GO(...) NTRNLVA_EXPAND(__VA_ARGS__)
+    #define NTRNLVA_EACH_SEL11(...)                                            \
+      NTRNLVA_EXPAND(NTRNLVA_EACH_SEL11_I(__VA_ARGS__))
 #else
-    #define NTRNLVA_OPT_I(opt, ...) __VA_OPT__(NTRNLVA_UP(opt))
-    #define VA_OPT(args, ...) NTRNLVA_OPT_I((__VA_ARGS__), NTRNLVA_UP(args))
-#endif /* NTRNLVA_IMPL check */
-#define VA_NOPT(args, ...)                                                     \
-  NTRNLVA_OPT_IMPL(VA_NOTEMPTY(NTRNLVA_UP(args)), __VA_ARGS__)
+    #define NTRNLVA_EACH_GO(...) __VA_ARGS__
+    #define NTRNLVA_EACH_SEL11(...) NTRNLVA_EACH_SEL11_I(__VA_ARGS__)
+#endif /* NTRNLVA_MSVC_TRADITIONAL check */
+
+/* A table hit names the tail; otherwise chunk n follows if it is defined */
+#define NTRNLVA_EACH_NEXT(n, ...)                                              \
+  NTRNLVA_EACH_NEXT_I(NTRNLVA_EACH_SEL11(__VA_ARGS__, NTRNLVA_EACH_TABLE_), n)
+#define NTRNLVA_EACH_NEXT_I(hit, n)                                            \
+  NTRNLVA_CAT(NTRNLVA_EACH_FIT_, NTRNLVA_CHECK_SENTINEL(hit))(hit, n)
+#define NTRNLVA_EACH_FIT_1(hit, n) NTRNLVA_NARGS_GET hit
+#define NTRNLVA_EACH_FIT_0(hit, n)                                             \
+  NTRNLVA_CAT(NTRNLVA_EACH_CHUNK_, NTRNLVA_IS_PAREN(NTRNLVA_EACH_HAS_C##n))(n)
+#define NTRNLVA_EACH_CHUNK_1(n) NTRNLVA_EACH_C##n
+#define NTRNLVA_EACH_CHUNK_0(n) NTRNLVA_EACH_OVER
+#define NTRNLVA_EACH_OVER(...) VA_FOR_EACH_capacity_exceeded
+
+#define NTRNLVA_EACH_FIRST(s, c, m, ...)                                       \
+  NTRNLVA_EACH_NEXT(0, __VA_ARGS__)(NTRNLVA_EMPTY, s, c, m, , __VA_ARGS__)
+#define NTRNLVA_EACH_START(s, c, m, ...)                                       \
+  NTRNLVA_EACH_GO(NTRNLVA_ELSE_IMPL(VA_ISEMPTY(__VA_ARGS__),                   \
+                                    NTRNLVA_EACH_FIRST, NTRNLVA_EMPTY)         \
+                  (s, c, m, __VA_ARGS__, ))
+#define VA_FOR_EACH(macro, ...)                                                \
+  NTRNLVA_EACH_START(NTRNLVA_EMPTY, NTRNLVA_EACH_CALL, macro, __VA_ARGS__)
+#define VA_FOR_EACH_I(macro, ...)                                              \
+  NTRNLVA_EACH_START(NTRNLVA_EMPTY, NTRNLVA_EACH_CALL_I, macro, __VA_ARGS__)
+#define VA_MAP(macro, ...)                                                     \
+  NTRNLVA_EACH_START(NTRNLVA_EACH_COMMA, NTRNLVA_EACH_CALL, macro, __VA_ARGS__)
+
+/* BEGIN GENERATED BY tools/gen_tables.py: each */
+#define NTRNLVA_EACH_SEL11_I(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, t, ...)  \
+  t
+#define NTRNLVA_EACH_TABLE_                                                    \
+  ()()(NTRNLVA_EACH_F9), ()()(NTRNLVA_EACH_F8), ()()(NTRNLVA_EACH_F7),         \
+  ()()(NTRNLVA_EACH_F6), ()()(NTRNLVA_EACH_F5), ()()(NTRNLVA_EACH_F4),         \
+  ()()(NTRNLVA_EACH_F3), ()()(NTRNLVA_EACH_F2), ()()(NTRNLVA_EACH_F1),         \
+  ()()(NTRNLVA_EACH_F0), ~
+#define NTRNLVA_EACH_F0(z, s, c, m, k, ...)
+#define NTRNLVA_EACH_F1(z, s, c, m, k, x0, ...) z()c(m, k##0, x0)
+#define NTRNLVA_EACH_F2(z, s, c, m, k, x0, x1, ...) z()c(m, k##0, x0)          \
+  s()c(m, k##1, x1)
+#define NTRNLVA_EACH_F3(z, s, c, m, k, x0, x1, x2, ...) z()c(m, k##0, x0)      \
+  s()c(m, k##1, x1) s()c(m, k##2, x2)
+#define NTRNLVA_EACH_F4(z, s, c, m, k, x0, x1, x2, x3, ...) z()c(m, k##0, x0)  \
+  s()c(m, k##1, x1) s()c(m, k##2, x2) s()c(m, k##3, x3)
+#define NTRNLVA_EACH_F5(z, s, c, m, k, x0, x1, x2, x3, x4, ...)                \
+  z()c(m, k##0, x0) s()c(m, k##1, x1) s()c(m, k##2, x2) s()c(m, k##3, x3)      \
+  s()c(m, k##4, x4)
+#define NTRNLVA_EACH_F6(z, s, c, m, k, x0, x1, x2, x3, x4, x5, ...)            \
+  z()c(m, k##0, x0) s()c(m, k##1, x1) s()c(m, k##2, x2) s()c(m, k##3, x3)      \
+  s()c(m, k##4, x4) s()c(m, k##5, x5)
+#define NTRNLVA_EACH_F7(z, s, c, m, k, x0, x1, x2, x3, x4, x5, x6, ...)        \
+  z()c(m, k##0, x0) s()c(m, k##1, x1) s()c(m, k##2, x2) s()c(m, k##3, x3)      \
+  s()c(m, k##4, x4) s()c(m, k##5, x5) s()c(m, k##6, x6)
+#define NTRNLVA_EACH_F8(z, s, c, m, k, x0, x1, x2, x3, x4, x5, x6, x7, ...)    \
+  z()c(m, k##0, x0) s()c(m, k##1, x1) s()c(m, k##2, x2) s()c(m, k##3, x3)      \
+  s()c(m, k##4, x4) s()c(m, k##5, x5) s()c(m, k##6, x6) s()c(m, k##7, x7)
+#define NTRNLVA_EACH_F9(z, s, c, m, k, x0, x1, x2, x3, x4, x5, x6, x7, x8,     \
+                        ...)                                                   \
+  z()c(m, k##0, x0) s()c(m, k##1, x1) s()c(m, k##2, x2) s()c(m, k##3, x3)      \
+  s()c(m, k##4, x4) s()c(m, k##5, x5) s()c(m, k##6, x6) s()c(m, k##7, x7)      \
+  s()c(m, k##8, x8)
+#define NTRNLVA_EACH_HAS_C0 ()
+#define NTRNLVA_EACH_C0(z, s, c, m, k, x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, \
+                        ...)                                                   \
+  z()c(m, 0, x0) s()c(m, 1, x1) s()c(m, 2, x2) s()c(m, 3, x3) s()c(m, 4, x4)   \
+  s()c(m, 5, x5) s()c(m, 6, x6) s()c(m, 7, x7) s()c(m, 8, x8) s()c(m, 9, x9)   \
+  NTRNLVA_EACH_GO(NTRNLVA_EACH_NEXT(1, __VA_ARGS__)                            \
+  (s, s, c, m, 1, __VA_ARGS__))
+#define NTRNLVA_EACH_HAS_C1 ()
+#define NTRNLVA_EACH_C1(z, s, c, m, k, x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, \
+                        ...)                                                   \
+  z()c(m, 10, x0) s()c(m, 11, x1) s()c(m, 12, x2) s()c(m, 13, x3)              \
+  s()c(m, 14, x4) s()c(m, 15, x5) s()c(m, 16, x6) s()c(m, 17, x7)              \
+  s()c(m, 18, x8) s()c(m, 19, x9)                                              \
+  NTRNLVA_EACH_GO(NTRNLVA_EACH_NEXT(2, __VA_ARGS__)                            \
+  (s, s, c, m, 2, __VA_ARGS__))
+#define NTRNLVA_EACH_HAS_C2 ()
+#define NTRNLVA_EACH_C2(z, s, c, m, k, x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, \
+                        ...)                                                   \
+  z()c(m, 20, x0) s()c(m, 21, x1) s()c(m, 22, x2) s()c(m, 23, x3)              \
+  s()c(m, 24, x4) s()c(m, 25, x5) s()c(m, 26, x6) s()c(m, 27, x7)              \
+  s()c(m, 28, x8) s()c(m, 29, x9)                                              \
+  NTRNLVA_EACH_GO(NTRNLVA_EACH_NEXT(3, __VA_ARGS__)                            \
+  (s, s, c, m, 3, __VA_ARGS__))
+#if VA_OPT_MAX_EACH > 32
+    #define NTRNLVA_EACH_HAS_C3 ()
+    #define NTRNLVA_EACH_C3(z, s, c, m, k, x0, x1, x2, x3, x4, x5, x6, x7, x8, \
+                            x9, ...)                                           \
+      z()c(m, 30, x0) s()c(m, 31, x1) s()c(m, 32, x2) s()c(m, 33, x3)          \
+      s()c(m, 34, x4) s()c(m, 35, x5) s()c(m, 36, x6) s()c(m, 37, x7)          \
+      s()c(m, 38, x8) s()c(m, 39, x9)                                          \
+      NTRNLVA_EACH_GO(NTRNLVA_EACH_NEXT(4, __VA_ARGS__)                        \
+      (s, s, c, m, 4, __VA_ARGS__))
+    #define NTRNLVA_EACH_HAS_C4 ()
+    #define NTRNLVA_EACH_C4(z, s, c, m, k, x0, x1, x2, x3, x4, x5, x6, x7, x8, \
+                            x9, ...)                                           \
+      z()c(m, 40, x0) s()c(m, 41, x1) s()c(m, 42, x2) s()c(m, 43, x3)          \
+      s()c(m, 44, x4) s()c(m, 45, x5) s()c(m, 46, x6) s()c(m, 47, x7)          \
+      s()c(m, 48, x8) s()c(m, 49, x9)                                          \
+      NTRNLVA_EACH_GO(NTRNLVA_EACH_NEXT(5, __VA_ARGS__)                        \
+      (s, s, c, m, 5, __VA_ARGS__))
+    #define NTRNLVA_EACH_HAS_C5 ()
+    #define NTRNLVA_EACH_C5(z, s, c, m, k, x0, x1, x2, x3, x4, x5, x6, x7, x8, \
+                            x9, ...)                                           \
+      z()c(m, 50, x0) s()c(m, 51, x1) s()c(m, 52, x2) s()c(m, 53, x3)          \
+      s()c(m, 54, x4) s()c(m, 55, x5) s()c(m, 56, x6) s()c(m, 57, x7)          \
+      s()c(m, 58, x8) s()c(m, 59, x9)                                          \
+      NTRNLVA_EACH_GO(NTRNLVA_EACH_NEXT(6, __VA_ARGS__)                        \
+      (s, s, c, m, 6, __VA_ARGS__))
+#endif
+#if VA_OPT_MAX_EACH > 64
+    #define NTRNLVA_EACH_HAS_C6 ()
+    #define NTRNLVA_EACH_C6(z, s, c, m, k, x0, x1, x2, x3, x4, x5, x6, x7, x8, \
+                            x9, ...)                                           \
+      z()c(m, 60, x0) s()c(m, 61, x1) s()c(m, 62, x2) s()c(m, 63, x3)          \
+      s()c(m, 64, x4) s()c(m, 65, x5) s()c(m, 66, x6) s()c(m, 67, x7)          \
+      s()c(m, 68, x8) s()c(m, 69, x9)                                          \
+      NTRNLVA_EACH_GO(NTRNLVA_EACH_NEXT(7, __VA_ARGS__)                        \
+      (s, s, c, m, 7, __VA_ARGS__))
+    #define NTRNLVA_EACH_HAS_C7 ()
+    #define NTRNLVA_EACH_C7(z, s, c, m, k, x0, x1, x2, x3, x4, x5, x6, x7, x8, \
+                            x9, ...)                                           \
+      z()c(m, 70, x0) s()c(m, 71, x1) s()c(m, 72, x2) s()c(m, 73, x3)          \
+      s()c(m, 74, x4) s()c(m, 75, x5) s()c(m, 76, x6) s()c(m, 77, x7)          \
+      s()c(m, 78, x8) s()c(m, 79, x9)                                          \
+      NTRNLVA_EACH_GO(NTRNLVA_EACH_NEXT(8, __VA_ARGS__)                        \
+      (s, s, c, m, 8, __VA_ARGS__))
+    #define NTRNLVA_EACH_HAS_C8 ()
+    #define NTRNLVA_EACH_C8(z, s, c, m, k, x0, x1, x2, x3, x4, x5, x6, x7, x8, \
+                            x9, ...)                                           \
+      z()c(m, 80, x0) s()c(m, 81, x1) s()c(m, 82, x2) s()c(m, 83, x3)          \
+      s()c(m, 84, x4) s()c(m, 85, x5) s()c(m, 86, x6) s()c(m, 87, x7)          \
+      s()c(m, 88, x8) s()c(m, 89, x9)                                          \
+      NTRNLVA_EACH_GO(NTRNLVA_EACH_NEXT(9, __VA_ARGS__)                        \
+      (s, s, c, m, 9, __VA_ARGS__))
+#endif
+#if VA_OPT_MAX_EACH > 96
+    #define NTRNLVA_EACH_HAS_C9 ()
+    #define NTRNLVA_EACH_C9(z, s, c, m, k, x0, x1, x2, x3, x4, x5, x6, x7, x8, \
+                            x9, ...)                                           \
+      z()c(m, 90, x0) s()c(m, 91, x1) s()c(m, 92, x2) s()c(m, 93, x3)          \
+      s()c(m, 94, x4) s()c(m, 95, x5) s()c(m, 96, x6) s()c(m, 97, x7)          \
+      s()c(m, 98, x8) s()c(m, 99, x9)                                          \
+      NTRNLVA_EACH_GO(NTRNLVA_EACH_NEXT(10, __VA_ARGS__)                       \
+      (s, s, c, m, 10, __VA_ARGS__))
+    #define NTRNLVA_EACH_HAS_C10 ()
+    #define NTRNLVA_EACH_C10(z, s, c, m, k, x0, x1, x2, x3, x4, x5, x6, x7,    \
+                             x8, x9, ...)                                      \
+      z()c(m, 100, x0) s()c(m, 101, x1) s()c(m, 102, x2) s()c(m, 103, x3)      \
+      s()c(m, 104, x4) s()c(m, 105, x5) s()c(m, 106, x6) s()c(m, 107, x7)      \
+      s()c(m, 108, x8) s()c(m, 109, x9)                                        \
+      NTRNLVA_EACH_GO(NTRNLVA_EACH_NEXT(11, __VA_ARGS__)                       \
+      (s, s, c, m, 11, __VA_ARGS__))
+    #define NTRNLVA_EACH_HAS_C11 ()
+    #define NTRNLVA_EACH_C11(z, s, c, m, k, x0, x1, x2, x3, x4, x5, x6, x7,    \
+                             x8, x9, ...)                                      \
+      z()c(m, 110, x0) s()c(m, 111, x1) s()c(m, 112, x2) s()c(m, 113, x3)      \
+      s()c(m, 114, x4) s()c(m, 115, x5) s()c(m, 116, x6) s()c(m, 117, x7)      \
+      s()c(m, 118, x8) s()c(m, 119, x9)                                        \
+      NTRNLVA_EACH_GO(NTRNLVA_EACH_NEXT(12, __VA_ARGS__)                       \
+      (s, s, c, m, 12, __VA_ARGS__))
+#endif
+/* END GENERATED: each */
 
 #ifdef TEST_VA_OPT
 #include <stdio.h>
+#include <string.h>
 
 #define EXPECT(test, expected, fail_msg_fmt, ...)                              \
   do {                                                                         \
@@ -364,6 +1075,122 @@ argument in the list passed to VA_OPT or VA_ISEMPTY */
     }                                                                          \
   } while (0)
 
+#define ARGS10 a, b, c, d, e, f, g, h, i, j
+#define ARGS100                                                                \
+  ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10
+#define ARGS1000                                                               \
+  ARGS100, ARGS100, ARGS100, ARGS100, ARGS100, ARGS100, ARGS100, ARGS100,      \
+  ARGS100, ARGS100
+
+/* Expected count, test args */
+#define NARGS_TEST_CASES NARGS_SHORT_TEST_CASES NARGS_WIDE_TEST_CASES
+#define NARGS_SHORT_TEST_CASES                                                 \
+  X(0, )                                                                       \
+  X(1, (a, b))                                                                 \
+  X(2, a, b)                                                                   \
+  X(2, MAC0, (void))                                                           \
+  X(3, EATER0, EATER1, MACMANYPLUS)                                            \
+  X(17, +, "many", "unpastable", "tokens", +, +, +, +, +, +, +, +, +, +, +, +, \
+    +)
+/* Longer than the 39 elements VA_FOR_EACH takes at VA_OPT_MAX_EACH 32 */
+#define NARGS_WIDE_TEST_CASES                                                  \
+  X(63, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, a, b, c)               \
+  X(64, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, a, b, c, d)
+
+/* Beyond the 64-argument table; not available with NTRNLVA_MSVC_TRADITIONAL */
+#define NARGS_LONG_TEST_CASES                                                  \
+  X(65, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, a, b, c, d, e)         \
+  X(128, ARGS100, ARGS10, ARGS10, a, b, c, d, e, f, g, h)                      \
+  X(129, ARGS100, ARGS10, ARGS10, a, b, c, d, e, f, g, h, i)                   \
+  X(1000, ARGS1000)
+
+#define TEST_OVL0() 0
+#define TEST_OVL1(a) 1
+#define TEST_OVL2(a, b) 2
+#define TEST_OVL3(a, b, c) 3
+#define TEST_OVL4(a, b, c, d) 4
+#define TEST_OVL5(a, b, c, d, e) 5
+#define TEST_OVL16(...) 16
+#define TEST_OVL17(...) 17
+#define TEST_OVL63(...) 63
+#define TEST_OVL64(...) 64
+
+#define TEST_P0() P0()
+#define TEST_P1(a) P1(a)
+#define TEST_P2(...) Pn(2, __VA_ARGS__)
+#define TEST_P3(...) Pn(3, __VA_ARGS__)
+#define TEST_P4(...) Pn(4, __VA_ARGS__)
+#define TEST_P16(...) Pn(16, __VA_ARGS__)
+#define TEST_P64(...) Pn(64, __VA_ARGS__)
+#define TEST_STR_I(...) #__VA_ARGS__
+#define TEST_STR(...) TEST_STR_I(__VA_ARGS__)
+
+/* Expected expansion, test args */
+#define OVERLOAD_TEST_CASES                                                    \
+  X("P0()", )                                                                  \
+  X("P0()", /*comment*/)                                                       \
+  X("P1(a)", a)                                                                \
+  X("P1((void))", (void))                                                      \
+  X("P1((a, b))", (a, b))                                                      \
+  X("P1(EATER1)", EATER1)                                                      \
+  X("P1(\"unpastable\")", "unpastable")                                        \
+  X("Pn(2, a, b)", a, b)                                                       \
+  X("Pn(3, EATER0, EATER1, MAC0)", EATER0, EATER1, MAC0)                       \
+  X("Pn(4, (void), b, c, d)", (void), b, c, d)                                 \
+  X("Pn(16, +, \"many\", +, +, +, +, +, +, +, +, +, +, +, +, +, +)", +,         \
+    "many", +, +, +, +, +, +, +, +, +, +, +, +, +, +)                          \
+  X(TEST_STR(Pn(64, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, a, b, c,   \
+                d)),                                                           \
+    ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, a, b, c, d)                \
+  X("VA_OVERLOAD_capacity_exceeded", ARGS10, ARGS10, ARGS10, ARGS10, ARGS10,   \
+    ARGS10, a, b, c, d, e)
+
+/* Compares two stringized expansions, ignoring the spaces that differ
+between implementations */
+static int same_tokens(const char *a, const char *b) {
+  for (;; a++, b++) {
+    while (*a == ' ') {
+      a++;
+    }
+    while (*b == ' ') {
+      b++;
+    }
+    if (*a != *b) {
+      return 0;
+    }
+    if (!*a) {
+      return 1;
+    }
+  }
+}
+
+#define TEST_EACH_ONE(x) +1
+#define TEST_EACH_IDX(i, x) +i
+#define TEST_MAP_ONE(x) 1
+/* Its chunks and a full tail: the longest list VA_OPT_MAX_EACH takes */
+#if VA_OPT_MAX_EACH > 96
+    #define EACH_LONG 129
+    #define EACH_LONG_ARGS                                                     \
+      ARGS100, ARGS10, ARGS10, a, b, c, d, e, f, g, h, i
+#elif VA_OPT_MAX_EACH > 64
+    #define EACH_LONG 99
+    #define EACH_LONG_ARGS                                                     \
+      ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10,  \
+      a, b, c, d, e, f, g, h, i
+#elif VA_OPT_MAX_EACH > 32
+    #define EACH_LONG 69
+    #define EACH_LONG_ARGS                                                     \
+      ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, ARGS10, a, b, c, d, e, f, g, h, i
+#else
+    #define EACH_LONG 39
+    #define EACH_LONG_ARGS ARGS10, ARGS10, ARGS10, a, b, c, d, e, f, g, h, i
+#endif
+
+#define TEST_BIT(isempty, ...) isempty
+#define TEST_BIT_OPT(isempty, ...)                                             \
+  1 VA_OPT_BIT(isempty, -1) VA_NOPT_BIT(isempty, -0)
+#define TEST_BIT_ELSE(isempty, ...) VA_OPT_ELSE_BIT(isempty, 0, 1)
+
 int main(void) {
 #if NTRNLVA_IMPL == NTRNLVA_IMPL_NATIVE
   printf("Testing with native __VA_OPT__ support\n");
@@ -373,6 +1200,9 @@ int main(void) {
   printf("Testing with MSVC style comma elision fallback\n");
 #else
   printf("Testing with C99 VA_OPT polyfill\n");
+#endif
+#ifdef NTRNLVA_CONFIGURED
+  printf("Implementation pinned by va_opt_config.h\n");
 #endif
   int passed = 0;
   int failed = 0;
@@ -396,6 +1226,83 @@ int main(void) {
          __VA_ARGS__);
   ISEMPTY_TEST_CASES
 #undef X
+#define X(expected, ...)                                                       \
+  EXPECT(VA_OPT_ELSE((__VA_ARGS__), 0, 1), expected,                           \
+         "VA_OPT_ELSE failed for args %s", __VA_ARGS__);
+  ISEMPTY_TEST_CASES
+#undef X
+#define X(expected, ...)                                                       \
+  EXPECT(VA_IF_EMPTY_ELSE((__VA_ARGS__), 1, 0), expected,                      \
+         "VA_IF_EMPTY_ELSE failed for args %s", __VA_ARGS__);
+  ISEMPTY_TEST_CASES
+#undef X
+#define X(expected, ...)                                                       \
+  EXPECT(VA_WITH_EMPTINESS((__VA_ARGS__), TEST_BIT, ~), expected,              \
+         "VA_WITH_EMPTINESS failed for args %s", __VA_ARGS__);
+  ISEMPTY_TEST_CASES
+#undef X
+#define X(expected, ...)                                                       \
+  EXPECT(VA_WITH_EMPTINESS((__VA_ARGS__), TEST_BIT_OPT, ~), expected,          \
+         "VA_OPT_BIT/VA_NOPT_BIT failed for args %s", __VA_ARGS__);
+  ISEMPTY_TEST_CASES
+#undef X
+#define X(expected, ...)                                                       \
+  EXPECT(VA_WITH_EMPTINESS((__VA_ARGS__), TEST_BIT_ELSE, ~), expected,         \
+         "VA_OPT_ELSE_BIT failed for args %s", __VA_ARGS__);
+  ISEMPTY_TEST_CASES
+#undef X
+#define X(expected, ...)                                                       \
+  EXPECT(VA_NARGS(__VA_ARGS__), !expected, "VA_NARGS failed for args %s",      \
+         __VA_ARGS__);
+  SINGLE_TEST_CASES
+#undef X
+#define X(expected, ...)                                                       \
+  EXPECT(VA_NARGS(__VA_ARGS__), expected, "VA_NARGS failed for args %s",       \
+         __VA_ARGS__);
+  NARGS_TEST_CASES
+#if !NTRNLVA_MSVC_TRADITIONAL
+  NARGS_LONG_TEST_CASES
+#endif
+#undef X
+#define X(expected, ...)                                                       \
+  EXPECT(VA_OVERLOAD(TEST_OVL, __VA_ARGS__), !expected,                        \
+         "VA_OVERLOAD failed for args %s", __VA_ARGS__);
+  SINGLE_TEST_CASES
+#undef X
+#define X(expected, ...)                                                       \
+  EXPECT(VA_OVERLOAD(TEST_OVL, __VA_ARGS__), expected,                         \
+         "VA_OVERLOAD failed for args %s", __VA_ARGS__);
+  NARGS_TEST_CASES
+#undef X
+#define X(expected, ...)                                                       \
+  EXPECT(same_tokens(TEST_STR(VA_OVERLOAD(TEST_P, __VA_ARGS__)), expected), 1, \
+         "VA_OVERLOAD failed for args %s", __VA_ARGS__);
+  OVERLOAD_TEST_CASES
+#undef X
+#define X(expected, ...)                                                       \
+  EXPECT(0 VA_FOR_EACH(TEST_EACH_ONE, __VA_ARGS__), expected,                  \
+         "VA_FOR_EACH failed for args %s", __VA_ARGS__);                       \
+  EXPECT(0 VA_FOR_EACH_I(TEST_EACH_IDX, __VA_ARGS__),                          \
+         expected * (expected - 1) / 2, "VA_FOR_EACH_I failed for args %s",    \
+         __VA_ARGS__);                                                         \
+  {                                                                            \
+    int map[] = {0, VA_MAP(TEST_MAP_ONE, __VA_ARGS__)};                        \
+    EXPECT((int)(sizeof(map) / sizeof(int)) - 1, expected,                     \
+           "VA_MAP failed for args %s", __VA_ARGS__);                          \
+  }
+  NARGS_SHORT_TEST_CASES
+#if EACH_LONG >= 64
+  NARGS_WIDE_TEST_CASES
+#endif
+#undef X
+  EXPECT(0 VA_FOR_EACH(TEST_EACH_ONE, EACH_LONG_ARGS), EACH_LONG,
+         "VA_FOR_EACH failed for args %s", EACH_LONG_ARGS);
+  EXPECT(0 VA_FOR_EACH_I(TEST_EACH_IDX, EACH_LONG_ARGS),
+         EACH_LONG * (EACH_LONG - 1) / 2, "VA_FOR_EACH_I failed for args %s",
+         EACH_LONG_ARGS);
+  EXPECT(!!strstr(TEST_STR(VA_FOR_EACH(TEST_EACH_ONE, EACH_LONG_ARGS, j)),
+                  "VA_FOR_EACH_capacity_exceeded"),
+         1, "VA_FOR_EACH failed for args %s", EACH_LONG_ARGS, j);
   printf("Tests passed: %d\n", passed);
   printf("Tests failed: %d\n", failed);
   if (failed == 0) {
@@ -0,0 +1,845 @@
+/* SPDX-License-Identifier: CC0-1.0 */
+
+#ifndef VA_PRINT_H
+#define VA_PRINT_H
+
+/*
+printf-style output specialized by argument count and type.
+Licensed as CC0 1.0 Universal.
+To view a copy of this license,
+visit https://creativecommons.org/publicdomain/zero/1.0/
+
+EXAMPLE USAGE:
+
+#define VA_PRINT_IMPLEMENTATION   // in exactly one source file
+#include "va_print.h"
+
+VA_PRINT("ready\n");                       // fwrite("ready\n", 1, 6, stdout)
+VA_PRINT("100%%\n");                       // fprintf(stdout, "100%%\n")
+VA_PRINT("%s: %d items\n", name, n);       // va_print_end(va_print_int(
+                                           //   va_print_string(..), n))
+VA_FPRINT(stderr, "took %.3f ms\n", ms);
+int len = VA_FORMAT(buf, sizeof(buf), "id=%u", id);
+
+DISPATCH:
+  fmt must be a string literal; anything else does not compile. With no
+  arguments after it, VA_ISEMPTY routes the call to fwrite (VA_FORMAT:
+  memcpy) with the length taken from sizeof, like fputs. A format with a '%'
+  goes to fprintf (VA_FORMAT: snprintf) instead, so "%%" prints '%' with or
+  without arguments; the choice folds away when optimizing. With one to
+  four arguments, VA_NARGS picks a chain of calls, one per argument, each
+  chosen by _Generic from the argument's type: va_print_int, va_print_uint,
+  va_print_double, va_print_string or va_print_pointer. Each writer copies
+  the literal text up to the next conversion, reads that one conversion and
+  formats its own argument, whose type it already knows, so nothing walks a
+  va_list. With five or more arguments the call is fprintf (VA_FORMAT:
+  snprintf). fmt is checked against the arguments like printf's in every
+  case (the check is never executed).
+
+FORMATTING:
+  Integers with only the '-' and '0' flags and a width, %c, and strings
+  with any width and precision are formatted by the writers themselves. A
+  conversion without flags, width or precision skips their parsing, and its
+  digits or bytes are copied into the buffer unpadded.
+  Other integer conversions, floating values and %p go through snprintf for
+  that one conversion. An integer is first converted to the type of the
+  conversion's length modifier, signed for %d and %i and unsigned for %o,
+  %u, %x and %X, as printf converts it. `*` is supported; %n consumes its
+  argument and writes nothing.
+
+  A call's text is built in a buffer owned by the calling thread and written
+  with one fwrite, so a line is not interleaved with other threads' output
+  on the same stream. Text longer than VA_PRINT_BUFFER (default 4096) bytes
+  is written in pieces. VA_FORMAT returns the length of what it formatted,
+  cut at VA_PRINT_BUFFER bytes, and stores at most size - 1 bytes of it
+  followed by a '\0'. VA_PRINT and VA_FPRINT are void expressions.
+
+  An argument may itself print; its text is written before the line that
+  is being built, as with printf. Calls nested that way more than
+  VA_PRINT_DEPTH (default 8) deep write nothing.
+
+LIMITS:
+  Requires C11 (_Generic, _Thread_local) or C++11, where overloads of
+  va_print_put take _Generic's place.
+
+RUN TESTS:
+    cc -x c -DTEST_VA_PRINT va_print.h -o va_print_test && ./va_print_test
+*/
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "va_internal.h"
+
+#ifndef VA_PRINT_BUFFER
+    #define VA_PRINT_BUFFER 4096
+#endif
+#ifndef VA_PRINT_DEPTH
+    #define VA_PRINT_DEPTH 8
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The writers take and return what is left of the format. The rest of a
+call's state is kept by the calling thread, one frame per call in progress. */
+const char *va_print_begin(FILE *out, const char *fmt);
+const char *va_print_int(const char *fmt, long long v);
+const char *va_print_uint(const char *fmt, unsigned long long v);
+const char *va_print_double(const char *fmt, double v);
+const char *va_print_string(const char *fmt, const char *v);
+const char *va_print_pointer(const char *fmt, const void *v);
+void va_print_end(const char *fmt);
+int va_format_end(const char *fmt, char *dst, size_t size);
+int va_format_literal(char *dst, size_t size, const char *text, size_t len);
+
+#ifdef __cplusplus
+}
+
+static inline const char *va_print_put(const char *f, long long v) {
+  return va_print_int(f, v);
+}
+static inline const char *va_print_put(const char *f, int v) {
+  return va_print_int(f, v);
+}
+static inline const char *va_print_put(const char *f, long v) {
+  return va_print_int(f, v);
+}
+static inline const char *va_print_put(const char *f, unsigned long long v) {
+  return va_print_uint(f, v);
+}
+static inline const char *va_print_put(const char *f, unsigned v) {
+  return va_print_uint(f, v);
+}
+static inline const char *va_print_put(const char *f, unsigned long v) {
+  return va_print_uint(f, v);
+}
+static inline const char *va_print_put(const char *f, double v) {
+  return va_print_double(f, v);
+}
+static inline const char *va_print_put(const char *f, long double v) {
+  return va_print_double(f, (double)v);
+}
+static inline const char *va_print_put(const char *f, const char *v) {
+  return va_print_string(f, v);
+}
+static inline const char *va_print_put(const char *f, const void *v) {
+  return va_print_pointer(f, v);
+}
+    #define NTRNLVA_PRINT_PUT(x) va_print_put
+#else
+    #define NTRNLVA_PRINT_PUT(x)                                               \
+      NTRNLVA_GENERIC_KIND(x, va_print_int, va_print_uint, va_print_double,    \
+                           va_print_double, va_print_string, va_print_pointer)
+#endif /* __cplusplus */
+
+/* The writer chains, innermost first */
+#define NTRNLVA_PRINT_1(s, a) NTRNLVA_PRINT_PUT(a)(s, a)
+#define NTRNLVA_PRINT_2(s, a, b)                                               \
+  NTRNLVA_PRINT_PUT(b)(NTRNLVA_PRINT_1(s, a), b)
+#define NTRNLVA_PRINT_3(s, a, b, c)                                            \
+  NTRNLVA_PRINT_PUT(c)(NTRNLVA_PRINT_2(s, a, b), c)
+#define NTRNLVA_PRINT_4(s, a, b, c, d)                                         \
+  NTRNLVA_PRINT_PUT(d)(NTRNLVA_PRINT_3(s, a, b, c), d)
+#define NTRNLVA_PRINT_CHAIN(s, ...)                                            \
+  NTRNLVA_CAT(NTRNLVA_PRINT_, VA_NARGS(__VA_ARGS__))(s, __VA_ARGS__)
+
+/* FIT is 1 for one to four arguments: the fifth of the list padded with
+empty arguments is then empty */
+#define NTRNLVA_PRINT_FIFTH(a, b, c, d, e, ...) e
+#define NTRNLVA_PRINT_FIT(...)                                                 \
+  VA_ISEMPTY(NTRNLVA_PRINT_FIFTH(__VA_ARGS__, , , , , ))
+
+/* Without arguments, a format with no '%' is written as is. strchr on the
+literal is folded when optimizing, as is fprintf without conversions. */
+#define NTRNLVA_FPRINT_1(out, fmt, ...)                                        \
+  (NTRNLVA_FORMAT_CHECK("" fmt "", ),                                          \
+   strchr("" fmt "", '%') ? (void)fprintf(out, "" fmt "")                      \
+                          : (void)fwrite(fmt, 1, sizeof(fmt) - 1, out))
+#define NTRNLVA_FPRINT_0(out, fmt, ...)                                        \
+  NTRNLVA_CAT(NTRNLVA_FPRINT_FIT_, NTRNLVA_PRINT_FIT(__VA_ARGS__))             \
+  (out, fmt, __VA_ARGS__)
+#define NTRNLVA_FPRINT_FIT_0(out, fmt, ...)                                    \
+  ((void)fprintf(out, "" fmt "", __VA_ARGS__))
+#define NTRNLVA_FPRINT_FIT_1(out, fmt, ...)                                    \
+  (NTRNLVA_FORMAT_CHECK("" fmt "", __VA_ARGS__),                               \
+   va_print_end(NTRNLVA_PRINT_CHAIN(va_print_begin(out, fmt), __VA_ARGS__)))
+
+#define NTRNLVA_FORMAT_1(dst, size, fmt, ...)                                  \
+  (NTRNLVA_FORMAT_CHECK("" fmt "", ),                                          \
+   strchr("" fmt "", '%') ? snprintf(dst, size, "" fmt "")                     \
+                          : va_format_literal(dst, size, fmt, sizeof(fmt) - 1))
+#define NTRNLVA_FORMAT_0(dst, size, fmt, ...)                                  \
+  NTRNLVA_CAT(NTRNLVA_FORMAT_FIT_, NTRNLVA_PRINT_FIT(__VA_ARGS__))             \
+  (dst, size, fmt, __VA_ARGS__)
+#define NTRNLVA_FORMAT_FIT_0(dst, size, fmt, ...)                              \
+  snprintf(dst, size, "" fmt "", __VA_ARGS__)
+#define NTRNLVA_FORMAT_FIT_1(dst, size, fmt, ...)                              \
+  (NTRNLVA_FORMAT_CHECK("" fmt "", __VA_ARGS__),                               \
+   va_format_end(NTRNLVA_PRINT_CHAIN(va_print_begin(NULL, fmt), __VA_ARGS__),  \
+                 dst, size))
+
+#define VA_FPRINT(stream, fmt, ...)                                            \
+  NTRNLVA_CAT(NTRNLVA_FPRINT_, VA_ISEMPTY(__VA_ARGS__))                        \
+  (stream, fmt, __VA_ARGS__)
+#define VA_PRINT(fmt, ...) VA_FPRINT(stdout, fmt, __VA_ARGS__)
+#define VA_FORMAT(dst, size, fmt, ...)                                         \
+  NTRNLVA_CAT(NTRNLVA_FORMAT_, VA_ISEMPTY(__VA_ARGS__))                        \
+  (dst, size, fmt, __VA_ARGS__)
+
+#if defined(VA_PRINT_IMPLEMENTATION) || defined(TEST_VA_PRINT)
+#include <stdarg.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct va_print_state {
+  const char *fmt; /* what is left of the format */
+  FILE *out;       /* NULL while formatting into a string */
+  size_t start;    /* where the call's text starts in the buffer */
+  int stars[2];    /* '*' values read for the next conversion */
+  int nstars;
+};
+
+/* depth counts every call in progress, including those past
+VA_PRINT_DEPTH, which have no frame and write nothing */
+static NTRNLVA_TLS struct {
+  size_t len;
+  unsigned depth;
+  struct va_print_state frames[VA_PRINT_DEPTH];
+  char buf[VA_PRINT_BUFFER];
+} va_print_tls_;
+
+/* The innermost call's frame, now at fmt, or NULL if it has none */
+static struct va_print_state *va_print_top(const char *fmt) {
+  struct va_print_state *s;
+  if (va_print_tls_.depth > VA_PRINT_DEPTH) {
+    return NULL;
+  }
+  s = &va_print_tls_.frames[va_print_tls_.depth - 1];
+  s->fmt = fmt;
+  return s;
+}
+
+enum {
+  NTRNLVA_PRINT_MINUS = 1,
+  NTRNLVA_PRINT_PLUS = 2,
+  NTRNLVA_PRINT_SPACE = 4,
+  NTRNLVA_PRINT_HASH = 8,
+  NTRNLVA_PRINT_ZERO = 16
+};
+
+/* One conversion: flags, width and precision (-1 when absent), the size of
+the integer its length modifier names and the conversion character */
+struct va_print_spec {
+  unsigned flags;
+  int width;
+  int prec;
+  size_t size;
+  char conv;
+};
+
+/* Writes out the call's text so far; returns 0 if it cannot make room */
+static int va_print_drain(struct va_print_state *s) {
+  if (!s->out || va_print_tls_.len == s->start) {
+    return 0;
+  }
+  fwrite(va_print_tls_.buf + s->start, 1, va_print_tls_.len - s->start,
+         s->out);
+  va_print_tls_.len = s->start;
+  return 1;
+}
+
+static void va_print_append(struct va_print_state *s, const char *p,
+                            size_t n) {
+  if (n <= VA_PRINT_BUFFER - va_print_tls_.len) {
+    memcpy(va_print_tls_.buf + va_print_tls_.len, p, n);
+    va_print_tls_.len += n;
+    return;
+  }
+  while (n) {
+    size_t room = VA_PRINT_BUFFER - va_print_tls_.len;
+    size_t k = n < room ? n : room;
+    memcpy(va_print_tls_.buf + va_print_tls_.len, p, k);
+    va_print_tls_.len += k;
+    p += k;
+    n -= k;
+    if (n && !va_print_drain(s)) {
+      /* Full with an enclosing call's text, or formatting into a string */
+      if (s->out) {
+        fwrite(p, 1, n, s->out);
+      }
+      return;
+    }
+  }
+}
+
+static void va_print_fill(struct va_print_state *s, char c, int n) {
+  char pad[32];
+  memset(pad, c, sizeof(pad));
+  for (; n > 0; n -= (int)sizeof(pad)) {
+    va_print_append(s, pad, n < (int)sizeof(pad) ? (size_t)n : sizeof(pad));
+  }
+}
+
+/* snprintf of one conversion straight into the buffer */
+static void va_print_vformat(struct va_print_state *s, const char *spec,
+                             ...) {
+  va_list ap;
+  int n;
+  for (;;) {
+    size_t room = VA_PRINT_BUFFER - va_print_tls_.len;
+    va_start(ap, spec);
+    n = vsnprintf(va_print_tls_.buf + va_print_tls_.len, room, spec, ap);
+    va_end(ap);
+    if (n < 0) {
+      return;
+    }
+    if ((size_t)n < room) {
+      va_print_tls_.len += (size_t)n;
+      return;
+    }
+    if (!va_print_drain(s)) {
+      break;
+    }
+  }
+  if (s->out) {
+    va_start(ap, spec);
+    vfprintf(s->out, spec, ap);
+    va_end(ap);
+  } else {
+    va_print_tls_.len = VA_PRINT_BUFFER - 1; /* cut */
+  }
+}
+
+/* Rebuilds the conversion with the given length modifier for snprintf */
+static void va_print_spec_text(const struct va_print_spec *sp,
+                               const char *length, char *out) {
+  static const char flags[] = "-+ #0";
+  char *p = out;
+  int i;
+  *p++ = '%';
+  for (i = 0; flags[i]; i++) {
+    if (sp->flags & (1u << i)) {
+      *p++ = flags[i];
+    }
+  }
+  if (sp->width >= 0) {
+    p += sprintf(p, "%d", sp->width);
+  }
+  if (sp->prec >= 0) {
+    p += sprintf(p, ".%d", sp->prec);
+  }
+  sprintf(p, "%s%c", length, sp->conv);
+}
+
+/* Copies the literal text before the next conversion into the buffer,
+turning "%%" into '%'. Returns where it stopped, which is short of the
+conversion only when the buffer is full. */
+static const char *va_print_literal(const char *f) {
+  char *o = va_print_tls_.buf + va_print_tls_.len;
+  char *end = va_print_tls_.buf + VA_PRINT_BUFFER;
+  for (; o < end; f++) {
+    char c = *f;
+    if (c == '%') {
+      if (f[1] != '%') {
+        break;
+      }
+      f++;
+    } else if (!c) {
+      break;
+    }
+    *o++ = c;
+  }
+  va_print_tls_.len = (size_t)(o - va_print_tls_.buf);
+  return f;
+}
+
+/* Reads a '*' value from the state or takes v as one. Returns 0 when v was
+taken. */
+static int va_print_star(struct va_print_state *s, int *star, int *value,
+                         long long v) {
+  if (s->nstars <= *star) {
+    s->stars[s->nstars++] = (int)v;
+    return 0;
+  }
+  *value = s->stars[(*star)++];
+  return 1;
+}
+
+/* Copies the literal text before the next conversion and reads it into sp.
+Returns 0 when the format has no conversion left, -1 when v is a '*' value
+the conversion still needs, 1 when v is the conversion's argument. */
+static int va_print_next(struct va_print_state *s, struct va_print_spec *sp,
+                         long long v) {
+  const char *f = s->fmt;
+  const char *length;
+  int star = 0;
+  for (;;) {
+    f = va_print_literal(f);
+    if (!*f) {
+      s->fmt = f;
+      return 0;
+    }
+    if (*f == '%' && f[1] != '%') {
+      break;
+    }
+    /* The buffer is full: the slow path makes room or cuts */
+    va_print_append(s, f, 1);
+    f += *f == '%' ? 2 : 1;
+  }
+  s->fmt = f++;
+  sp->flags = 0;
+  sp->width = -1;
+  sp->prec = -1;
+  /* Flags, width and precision are all below 'A', length modifiers and
+  conversions are letters, so a bare conversion skips this */
+  if (*f < 'A') {
+    for (;; f++) {
+      switch (*f) {
+      case '-': sp->flags |= NTRNLVA_PRINT_MINUS; continue;
+      case '+': sp->flags |= NTRNLVA_PRINT_PLUS; continue;
+      case ' ': sp->flags |= NTRNLVA_PRINT_SPACE; continue;
+      case '#': sp->flags |= NTRNLVA_PRINT_HASH; continue;
+      case '0': sp->flags |= NTRNLVA_PRINT_ZERO; continue;
+      }
+      break;
+    }
+    if (*f == '*') {
+      if (!va_print_star(s, &star, &sp->width, v)) {
+        return -1;
+      }
+      if (sp->width < 0) {
+        sp->width = -sp->width;
+        sp->flags |= NTRNLVA_PRINT_MINUS;
+      }
+      f++;
+    } else if (*f >= '0' && *f <= '9') {
+      for (sp->width = 0; *f >= '0' && *f <= '9'; f++) {
+        sp->width = sp->width * 10 + (*f - '0');
+      }
+    }
+    if (*f == '.') {
+      f++;
+      if (*f == '*') {
+        if (!va_print_star(s, &star, &sp->prec, v)) {
+          return -1;
+        }
+        sp->prec = sp->prec < 0 ? -1 : sp->prec;
+        f++;
+      } else {
+        for (sp->prec = 0; *f >= '0' && *f <= '9'; f++) {
+          sp->prec = sp->prec * 10 + (*f - '0');
+        }
+      }
+    }
+  }
+  length = f;
+  while (*f == 'h' || *f == 'l' || *f == 'j' || *f == 'z' || *f == 't' ||
+         *f == 'L' || *f == 'q') {
+    f++;
+  }
+  sp->size = va_int_size(length, (size_t)(f - length));
+  sp->conv = *f;
+  s->fmt = *f ? f + 1 : f;
+  s->nstars = 0;
+  return sp->conv && sp->conv != 'n';
+}
+
+/* Writes sign and digits padded to the width, as '-' and '0' ask */
+static void va_print_pad(struct va_print_state *s,
+                         const struct va_print_spec *sp, char sign,
+                         const char *digits, size_t n) {
+  int pad = sp->width - (int)n - (sign != 0);
+  int left = sp->flags & NTRNLVA_PRINT_MINUS;
+  int zero = !left && (sp->flags & NTRNLVA_PRINT_ZERO);
+  if (pad > 0 && !left && !zero) {
+    va_print_fill(s, ' ', pad);
+  }
+  if (sign) {
+    va_print_append(s, &sign, 1);
+  }
+  if (pad > 0 && zero) {
+    va_print_fill(s, '0', pad);
+  }
+  va_print_append(s, digits, n);
+  if (pad > 0 && left) {
+    va_print_fill(s, ' ', pad);
+  }
+}
+
+/* Whether the writers format this integer or %f themselves */
+static int va_print_plain(const struct va_print_spec *sp) {
+  return !(sp->flags & ~(unsigned)(NTRNLVA_PRINT_MINUS | NTRNLVA_PRINT_ZERO));
+}
+
+/* Writes the digits of u before end; returns where they start */
+static char *va_print_utoa(char *end, unsigned long long u, unsigned base,
+                           int upper) {
+  const char *hex = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+  if (base == 10) { /* a constant divisor, which needs no division */
+    do {
+      *--end = (char)('0' + u % 10);
+      u /= 10;
+    } while (u);
+    return end;
+  }
+  do {
+    *--end = hex[u % base];
+    u /= base;
+  } while (u);
+  return end;
+}
+
+static void va_print_integer(struct va_print_state *s,
+                             const struct va_print_spec *sp, int negative,
+                             unsigned long long u) {
+  char digits[24];
+  char *end = digits + sizeof(digits);
+  char *p = va_print_utoa(end, u,
+                          sp->conv == 'o' ? 8
+                          : sp->conv == 'x' || sp->conv == 'X' ? 16 : 10,
+                          sp->conv == 'X');
+  if (sp->width < 0) {
+    if (negative) {
+      *--p = '-';
+    }
+    va_print_append(s, p, (size_t)(end - p));
+    return;
+  }
+  va_print_pad(s, sp, negative ? '-' : 0, p, (size_t)(end - p));
+}
+
+static int va_print_is_float(char conv) {
+  switch (conv) {
+  case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a':
+  case 'A':
+    return 1;
+  }
+  return 0;
+}
+
+/* %f with a precision up to 9 from a scaled integer. The product of the
+value and a power of ten is off by at most one unit in its last place, so
+where that could decide the rounding, snprintf formats it instead. */
+static int va_print_fixed(struct va_print_state *s,
+                          const struct va_print_spec *sp, double v) {
+  static const unsigned long long pow10[] = {
+      1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+      1000000000};
+  int prec = sp->prec < 0 ? 6 : sp->prec;
+  int negative = v < 0 || (v == 0 && 1 / v < 0);
+  double scaled, off;
+  unsigned long long r;
+  char digits[32];
+  char *end = digits + sizeof(digits);
+  char *p = end;
+  if ((sp->conv != 'f' && sp->conv != 'F') || prec > 9 ||
+      !va_print_plain(sp)) {
+    return 0;
+  }
+  scaled = (negative ? -v : v) * (double)pow10[prec];
+  if (!(scaled < 4503599627370496.0)) { /* 2^52, and not NaN */
+    return 0;
+  }
+  r = (unsigned long long)scaled;
+  off = scaled - (double)r - 0.5;
+  if ((off < 0 ? -off : off) <= scaled * 2.3e-16) {
+    return 0;
+  }
+  r += off > 0;
+  if (prec) {
+    p = va_print_utoa(end, r % pow10[prec] + pow10[prec], 10, 0) + 1;
+    *--p = '.';
+  }
+  p = va_print_utoa(p, r / pow10[prec], 10, 0);
+  va_print_pad(s, sp, negative ? '-' : 0, p, (size_t)(end - p));
+  return 1;
+}
+
+const char *va_print_begin(FILE *out, const char *fmt) {
+  struct va_print_state *s;
+  if (++va_print_tls_.depth > VA_PRINT_DEPTH) {
+    return fmt;
+  }
+  s = va_print_top(fmt);
+  s->out = out;
+  s->start = va_print_tls_.len;
+  s->nstars = 0;
+  return fmt;
+}
+
+/* Formats an integer argument: i when is_signed, u otherwise. Integer
+conversions first convert it to the type of their length modifier. */
+static void va_print_whole(struct va_print_state *s, struct va_print_spec *sp,
+                           int is_signed, long long i, unsigned long long u) {
+  char spec[48];
+  if (sp->conv == 'c') {
+    char c = (char)u;
+    va_print_pad(s, sp, 0, &c, 1);
+    return;
+  }
+  if (va_print_is_float(sp->conv)) {
+    va_print_spec_text(sp, "", spec);
+    va_print_vformat(s, spec, is_signed ? (double)i : (double)u);
+    return;
+  }
+  switch (sp->conv) {
+  case 'd': case 'i':
+    is_signed = 1;
+    break;
+  case 'o': case 'u': case 'x': case 'X':
+    is_signed = 0;
+    break;
+  default:
+    sp->conv = is_signed ? 'd' : 'u';
+    break;
+  }
+  u = va_int_cut(u, sp->size, is_signed);
+  i = (long long)u;
+  if (!va_print_plain(sp) || sp->prec >= 0) {
+    va_print_spec_text(sp, "ll", spec);
+    if (is_signed) {
+      va_print_vformat(s, spec, i);
+    } else {
+      va_print_vformat(s, spec, u);
+    }
+  } else if (!is_signed) {
+    va_print_integer(s, sp, 0, u);
+  } else {
+    va_print_integer(s, sp, i < 0, i < 0 ? 0ull - u : u);
+  }
+}
+
+const char *va_print_int(const char *fmt, long long v) {
+  struct va_print_state *s = va_print_top(fmt);
+  struct va_print_spec sp;
+  if (!s) {
+    return fmt;
+  }
+  if (va_print_next(s, &sp, v) > 0) {
+    va_print_whole(s, &sp, 1, v, (unsigned long long)v);
+  }
+  return s->fmt;
+}
+
+const char *va_print_uint(const char *fmt, unsigned long long v) {
+  struct va_print_state *s = va_print_top(fmt);
+  struct va_print_spec sp;
+  if (!s) {
+    return fmt;
+  }
+  if (va_print_next(s, &sp, (long long)v) > 0) {
+    va_print_whole(s, &sp, 0, (long long)v, v);
+  }
+  return s->fmt;
+}
+
+const char *va_print_double(const char *fmt, double v) {
+  struct va_print_state *s = va_print_top(fmt);
+  struct va_print_spec sp;
+  char spec[48];
+  if (!s) {
+    return fmt;
+  }
+  if (va_print_next(s, &sp, (long long)v) <= 0) {
+    return s->fmt;
+  }
+  if (!va_print_is_float(sp.conv)) {
+    sp.conv = 'g';
+  }
+  if (!va_print_fixed(s, &sp, v)) {
+    va_print_spec_text(&sp, "", spec);
+    va_print_vformat(s, spec, v);
+  }
+  return s->fmt;
+}
+
+const char *va_print_string(const char *fmt, const char *v) {
+  struct va_print_state *s = va_print_top(fmt);
+  struct va_print_spec sp;
+  size_t n = 0;
+  if (!s) {
+    return fmt;
+  }
+  if (va_print_next(s, &sp, 0) <= 0) {
+    return s->fmt;
+  }
+  if (sp.conv == 'p') {
+    va_print_vformat(s, "%p", (const void *)v);
+    return s->fmt;
+  }
+  if (!v) {
+    v = "(null)";
+  }
+  if (sp.prec < 0) {
+    n = strlen(v);
+    if (sp.width < 0) {
+      va_print_append(s, v, n);
+      return s->fmt;
+    }
+  } else {
+    while (n < (size_t)sp.prec && v[n]) {
+      n++;
+    }
+  }
+  sp.flags &= NTRNLVA_PRINT_MINUS;
+  va_print_pad(s, &sp, 0, v, n);
+  return s->fmt;
+}
+
+const char *va_print_pointer(const char *fmt, const void *v) {
+  struct va_print_state *s = va_print_top(fmt);
+  struct va_print_spec sp;
+  char spec[48];
+  if (!s) {
+    return fmt;
+  }
+  if (va_print_next(s, &sp, 0) > 0) {
+    sp.conv = 'p';
+    va_print_spec_text(&sp, "", spec);
+    va_print_vformat(s, spec, v);
+  }
+  return s->fmt;
+}
+
+/* Copies what is left of the format, dropping unmatched conversions, and
+ends the call. Returns its frame, or NULL if it had none. */
+static struct va_print_state *va_print_finish(const char *fmt) {
+  struct va_print_state *s = va_print_top(fmt);
+  struct va_print_spec sp;
+  va_print_tls_.depth--;
+  if (!s) {
+    return NULL;
+  }
+  while (*s->fmt) {
+    va_print_next(s, &sp, 0);
+  }
+  return s;
+}
+
+void va_print_end(const char *fmt) {
+  struct va_print_state *s = va_print_finish(fmt);
+  if (s) {
+    va_print_drain(s);
+  }
+}
+
+int va_format_end(const char *fmt, char *dst, size_t size) {
+  struct va_print_state *s = va_print_finish(fmt);
+  size_t n;
+  if (!s) {
+    return va_format_literal(dst, size, "", 0);
+  }
+  n = va_print_tls_.len - s->start;
+  va_print_tls_.len = s->start;
+  return va_format_literal(dst, size, va_print_tls_.buf + s->start, n);
+}
+
+int va_format_literal(char *dst, size_t size, const char *text, size_t len) {
+  if (size) {
+    size_t k = len < size - 1 ? len : size - 1;
+    memmove(dst, text, k);
+    dst[k] = '\0';
+  }
+  return (int)len;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* VA_PRINT_IMPLEMENTATION */
+
+#ifdef TEST_VA_PRINT
+#define NTRNLVA_TEST
+#include "va_internal.h"
+
+/* Formats with VA_FORMAT and snprintf and compares the two */
+#define EXPECT_SAME(...)                                                       \
+  do {                                                                         \
+    char got[256], want[256];                                                  \
+    int n = VA_FORMAT(got, sizeof(got), __VA_ARGS__);                          \
+    int m = snprintf(want, sizeof(want), __VA_ARGS__);                         \
+    if (n != m || strcmp(got, want) != 0) {                                    \
+      printf("Test failed: VA_FORMAT(%s) gave \"%s\" (%d), snprintf \"%s\" "   \
+             "(%d)\n",                                                         \
+             #__VA_ARGS__, got, n, want, m);                                   \
+      failed++;                                                                \
+    } else {                                                                   \
+      passed++;                                                                \
+    }                                                                          \
+  } while (0)
+
+static FILE *stream;
+#define EXPECT_PRINT(stmt, expected) EXPECT_OUTPUT(stream, stmt, expected)
+
+static int nested(void) {
+  VA_FPRINT(stream, "[%s]", "inner");
+  return 7;
+}
+
+int main(void) {
+  char small[6];
+  char line[32];
+  char *null = NULL;
+  const char *name = "alice";
+  unsigned char byte = 200;
+  long big = -9223372036854775807L - 1;
+  size_t size = 4096;
+  int i = 42;
+
+  EXPECT_SAME("%d", i);
+  EXPECT_SAME("%d|%5d|%-5d|%05d|%i", -i, i, -i, -i, 0);
+  EXPECT_SAME("%u %x %X %o %c", 3000000000u, 255, 255, 8, 'z');
+  EXPECT_SAME("%ld %lu", big, (unsigned long)big);
+  EXPECT_SAME("n=%u, %lu", 7u, 0ul);
+  EXPECT_SAME("%zu bytes, %hhu", size, byte);
+  EXPECT_SAME("%+d % d %#x %.3d %8.3o", i, i, i, i, i);
+  EXPECT_SAME("%s|%8s|%-8s|%.3s|%*.*s", name, name, name, name, 7, 2, name);
+  EXPECT_SAME("%*d|%-*d|%.*f", -6, i, 4, i, 2, 3.14159);
+  EXPECT_SAME("%f %.3f %e %g", 0.1, 2.0 / 3, 12345.678, 1e-10);
+  EXPECT_SAME("%8.2f|%-8.1e|%G", -1.5, 250.0, 1e20);
+  EXPECT_SAME("100%% of %d%%", 3);
+  EXPECT_SAME("user %s id %d took %.2f ms", name, i, 1.25);
+  EXPECT_SAME("%x %X %u %o", -1, -2, -5, -8);
+  EXPECT_SAME("%hhx %hx %hhd %hd", (signed char)-1, (short)-2, 200, 40000);
+  EXPECT_SAME("%d|%i|%hhd", 0xFFFFFFFFu, 3000000000u, (unsigned char)200);
+  EXPECT_SAME("%lx %llu %zx %#x|%-10x|%08o", -1L, -1LL, size, -1, -3, -4);
+  EXPECT_SAME("%d %d %d %d %d", 1, 2, 3, 4, 5); /* snprintf */
+
+  /* NULL is written as "(null)"; handing it to snprintf would be undefined */
+  EXPECT(VA_FORMAT(line, sizeof(line), "%s %s", "x", null), 8);
+  EXPECT(strcmp(line, "x (null)"), 0);
+  EXPECT(VA_FORMAT(line, sizeof(line), "[%-7.3s]", null), 9);
+  EXPECT(strcmp(line, "[(nu    ]"), 0);
+
+  /* No arguments: written as is, but for "%%" */
+  EXPECT(VA_FORMAT(small, sizeof(small), "plain"), 5);
+  EXPECT(strcmp(small, "plain"), 0);
+  EXPECT(VA_FORMAT(small, sizeof(small), "%%"), 1);
+  EXPECT(strcmp(small, "%"), 0);
+  /* Cut to size - 1, returning the full length */
+  EXPECT(VA_FORMAT(small, sizeof(small), "%s-%d", name, 12345), 11);
+  EXPECT(strcmp(small, "alice"), 0);
+
+  EXPECT_PRINT(VA_FPRINT(stream, "hello\n"), "hello\n");
+  EXPECT_PRINT(VA_FPRINT(stream, "100%%\n"), "100%\n");
+  EXPECT_PRINT(VA_FPRINT(stream, "%s=%d\n", "a, b", (1 + 2)), "a, b=3\n");
+  EXPECT_PRINT(VA_FPRINT(stream, "%d %d %d %d %d %d\n", 1, 2, 3, 4, 5, 6),
+               "1 2 3 4 5 6\n");
+  /* Arguments are evaluated once; a call made while evaluating one is
+  written before the line, as with printf */
+  EXPECT_PRINT(VA_FPRINT(stream, "%d %d|", side_effect(), nested()),
+               "[inner]1 7|");
+  EXPECT(evaluated, 1);
+  /* Every call is a void expression */
+  EXPECT_PRINT((VA_FPRINT(stream, "x"), VA_FPRINT(stream, "%d", 1)), "x1");
+
+  return test_report();
+}
+#endif /* TEST_VA_PRINT */
+
+#endif /* VA_PRINT_H */
@@ -0,0 +1,571 @@
+/* SPDX-License-Identifier: CC0-1.0 */
+
+#ifndef VA_TRACE_H
+#define VA_TRACE_H
+
+/*
+Scoped tracing on top of va_opt.h, written out as Chrome trace-event JSON.
+Licensed as CC0 1.0 Universal.
+To view a copy of this license,
+visit https://creativecommons.org/publicdomain/zero/1.0/
+
+EXAMPLE USAGE:
+
+#define VA_TRACE_IMPLEMENTATION   // in exactly one source file
+#include "va_trace.h"
+
+void load(const char *path) {
+  VA_TRACE_SCOPE("load");                       // timestamps only
+  VA_TRACE_SCOPE("read", ("file", path), ("retry", 0));
+  ...
+  VA_TRACE_EVENT("cache miss", ("key", path));  // instant event
+}                                               // both spans end here
+
+FILE *f = fopen("trace.json", "w");
+va_trace_write(f);    // load in chrome://tracing or ui.perfetto.dev
+
+SPANS:
+  VA_TRACE_SCOPE(name, ...) opens a span that ends with the enclosing block,
+  through a destructor in C++ and __attribute__((cleanup)) in C (GCC, Clang).
+  VA_TRACE_EVENT(name, ...) records an instant. name must outlive the trace,
+  as string literals do. Each optional attribute is a parenthesized
+  ("key", value) pair. Integers, floating values and strings are stored;
+  strings are copied. A NaN or infinite value is written as null, which JSON
+  has in place of them. Without attributes, VA_OPT_ELSE selects a span that
+  takes its two timestamps and nothing else.
+
+BUFFERS:
+  Each thread appends to its own buffer, registered on its first span.
+  VA_TRACE_MAX_EVENTS (default 1 << 16) events, VA_TRACE_MAX_ATTRS (4096)
+  attributes and VA_TRACE_MAX_STRINGS (1 << 16) bytes of attribute strings
+  per thread; past that, records are dropped and counted. va_trace_write()
+  writes every buffer as one JSON document and va_trace_reset() empties
+  them. Neither may run while other threads are tracing.
+
+DISABLING:
+  Define VA_TRACE_DISABLE to expand every macro to ((void)0), arguments
+  included. va_trace_write() then writes an empty trace.
+
+RUN TESTS:
+    cc -x c -pthread -DTEST_VA_TRACE va_trace.h -o va_trace_test &&
+      ./va_trace_test
+  and again with -DVA_TRACE_DISABLE.
+*/
+
+#include <stdio.h>
+
+#include "va_internal.h"
+
+#ifndef VA_TRACE_MAX_EVENTS
+    #define VA_TRACE_MAX_EVENTS (1 << 16)
+#endif
+#ifndef VA_TRACE_MAX_ATTRS
+    #define VA_TRACE_MAX_ATTRS 4096
+#endif
+#ifndef VA_TRACE_MAX_STRINGS
+    #define VA_TRACE_MAX_STRINGS (1 << 16)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct va_trace_span {
+  const char *name;
+  unsigned long long start; /* ns */
+  unsigned attrs;           /* first attribute, in the thread's buffer */
+  unsigned nattrs;
+};
+
+int va_trace_write(FILE *out);
+void va_trace_reset(void);
+unsigned long va_trace_dropped(void);
+
+unsigned long long va_trace_now(void);
+unsigned va_trace_mark(void);
+void va_trace_end(struct va_trace_span *span);
+void va_trace_instant(const char *name, unsigned attrs, unsigned nattrs);
+void va_trace_put_int(const char *key, long long value);
+void va_trace_put_uint(const char *key, unsigned long long value);
+void va_trace_put_double(const char *key, double value);
+void va_trace_put_string(const char *key, const char *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef VA_TRACE_DISABLE
+    #define VA_TRACE_SCOPE(...) ((void)0)
+    #define VA_TRACE_EVENT(...) ((void)0)
+#else
+
+/* A fresh span variable name. __LINE__ would repeat for two scopes on one
+line, as in a macro that opens two; the name is made once per scope and passed
+down, since every use of __COUNTER__ differs. */
+#ifdef __COUNTER__
+    #define NTRNLVA_TRACE_VAR NTRNLVA_CAT(va_trace_span_, __COUNTER__)
+#else
+    #define NTRNLVA_TRACE_VAR NTRNLVA_CAT(va_trace_span_, __LINE__)
+#endif
+
+#ifdef __cplusplus
+struct va_trace_scope {
+  struct va_trace_span span;
+  ~va_trace_scope() { va_trace_end(&span); }
+};
+static inline void va_trace_put(const char *k, long long v) {
+  va_trace_put_int(k, v);
+}
+static inline void va_trace_put(const char *k, int v) {
+  va_trace_put_int(k, v);
+}
+static inline void va_trace_put(const char *k, unsigned v) {
+  va_trace_put_uint(k, v);
+}
+static inline void va_trace_put(const char *k, long v) {
+  va_trace_put_int(k, v);
+}
+static inline void va_trace_put(const char *k, unsigned long v) {
+  va_trace_put_uint(k, v);
+}
+static inline void va_trace_put(const char *k, unsigned long long v) {
+  va_trace_put_uint(k, v);
+}
+static inline void va_trace_put(const char *k, double v) {
+  va_trace_put_double(k, v);
+}
+static inline void va_trace_put(const char *k, long double v) {
+  va_trace_put_double(k, (double)v);
+}
+static inline void va_trace_put(const char *k, const char *v) {
+  va_trace_put_string(k, v);
+}
+    #define NTRNLVA_TRACE_PUT_I(key, value) va_trace_put(key, value);
+    #define NTRNLVA_TRACE_LOCAL(var, name, start, attrs)                       \
+      va_trace_scope var = {{name, start, attrs, 0}}
+    #define NTRNLVA_TRACE_SPAN(var) var.span
+#else
+    #define NTRNLVA_TRACE_PUT_I(key, value)                                    \
+      NTRNLVA_GENERIC_KIND(value, va_trace_put_int, va_trace_put_uint,         \
+                           va_trace_put_double, va_trace_put_double,           \
+                           va_trace_put_string, va_trace_put_int)(key, value);
+    #define NTRNLVA_TRACE_LOCAL(var, name, start, attrs)                       \
+      struct va_trace_span var                                                 \
+          __attribute__((cleanup(va_trace_end))) = {name, start, attrs, 0}
+    #define NTRNLVA_TRACE_SPAN(var) var
+#endif /* __cplusplus */
+#define NTRNLVA_TRACE_PUT(pair) NTRNLVA_TRACE_PUT_I pair
+
+/* The attributes go to the buffer before the start time is taken, so their
+cost is not part of the span */
+#define NTRNLVA_TRACE_SCOPE_PLAIN(var, name, ...)                              \
+  NTRNLVA_TRACE_LOCAL(var, name, va_trace_now(), 0)
+#define NTRNLVA_TRACE_SCOPE_ATTRS(var, name, ...)                              \
+  NTRNLVA_TRACE_LOCAL(var, name, 0, va_trace_mark());                          \
+  VA_FOR_EACH(NTRNLVA_TRACE_PUT, __VA_ARGS__)                                  \
+  NTRNLVA_TRACE_SPAN(var).nattrs =                                             \
+      va_trace_mark() - NTRNLVA_TRACE_SPAN(var).attrs;                         \
+  NTRNLVA_TRACE_SPAN(var).start = va_trace_now()
+#define NTRNLVA_TRACE_SCOPE_I(var, name, ...)                                  \
+  VA_OPT_ELSE((__VA_ARGS__), NTRNLVA_TRACE_SCOPE_ATTRS,                        \
+              NTRNLVA_TRACE_SCOPE_PLAIN)(var, name, __VA_ARGS__)
+#define NTRNLVA_TRACE_EVENT_PLAIN(name, ...) va_trace_instant(name, 0, 0)
+#define NTRNLVA_TRACE_EVENT_ATTRS(name, ...)                                   \
+  do {                                                                         \
+    unsigned va_trace_attrs_ = va_trace_mark();                                \
+    VA_FOR_EACH(NTRNLVA_TRACE_PUT, __VA_ARGS__)                                \
+    va_trace_instant(name, va_trace_attrs_,                                    \
+                     va_trace_mark() - va_trace_attrs_);                       \
+  } while (0)
+
+#define VA_TRACE_SCOPE(name, ...)                                              \
+  NTRNLVA_TRACE_SCOPE_I(NTRNLVA_TRACE_VAR, name, __VA_ARGS__)
+#define VA_TRACE_EVENT(name, ...)                                              \
+  VA_OPT_ELSE((__VA_ARGS__), NTRNLVA_TRACE_EVENT_ATTRS,                        \
+              NTRNLVA_TRACE_EVENT_PLAIN)(name, __VA_ARGS__)
+
+#endif /* VA_TRACE_DISABLE */
+
+#if defined(VA_TRACE_IMPLEMENTATION) || defined(TEST_VA_TRACE)
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum { VA_TRACE_INT, VA_TRACE_UINT, VA_TRACE_DOUBLE, VA_TRACE_STRING };
+
+struct va_trace_attr {
+  const char *key;
+  int tag;
+  union {
+    long long i;
+    unsigned long long u;
+    double d;
+    unsigned s; /* offset into the thread's strings */
+  } v;
+};
+
+struct va_trace_event {
+  const char *name;
+  unsigned long long ts, dur;
+  unsigned attrs, nattrs;
+  char phase; /* 'X' complete, 'i' instant */
+};
+
+struct va_trace_buffer {
+  struct va_trace_buffer *next;
+  unsigned tid, nevents, nattrs, nstrings;
+  unsigned long dropped;
+  struct va_trace_event events[VA_TRACE_MAX_EVENTS];
+  struct va_trace_attr attrs[VA_TRACE_MAX_ATTRS];
+  char strings[VA_TRACE_MAX_STRINGS];
+};
+
+static struct va_trace_buffer *va_trace_buffers_;
+static unsigned va_trace_tids_;
+static pthread_mutex_t va_trace_lock_ = PTHREAD_MUTEX_INITIALIZER;
+static NTRNLVA_TLS struct va_trace_buffer *va_trace_buf_;
+
+static struct va_trace_buffer *va_trace_buffer(void) {
+  struct va_trace_buffer *b = va_trace_buf_;
+  if (!b) {
+    b = (struct va_trace_buffer *)malloc(sizeof(*b));
+    if (!b) {
+      return NULL;
+    }
+    b->nevents = b->nattrs = b->nstrings = 0;
+    b->dropped = 0;
+    pthread_mutex_lock(&va_trace_lock_);
+    b->tid = ++va_trace_tids_;
+    b->next = va_trace_buffers_;
+    va_trace_buffers_ = b;
+    pthread_mutex_unlock(&va_trace_lock_);
+    va_trace_buf_ = b;
+  }
+  return b;
+}
+
+unsigned long long va_trace_now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (unsigned long long)t.tv_sec * 1000000000u +
+         (unsigned long long)t.tv_nsec;
+}
+
+unsigned va_trace_mark(void) {
+  struct va_trace_buffer *b = va_trace_buffer();
+  return b ? b->nattrs : 0;
+}
+
+static struct va_trace_attr *va_trace_attr(const char *key, int tag) {
+  struct va_trace_buffer *b = va_trace_buffer();
+  if (!b || b->nattrs == VA_TRACE_MAX_ATTRS) {
+    if (b) {
+      b->dropped++;
+    }
+    return NULL;
+  }
+  b->attrs[b->nattrs].key = key;
+  b->attrs[b->nattrs].tag = tag;
+  return &b->attrs[b->nattrs++];
+}
+
+void va_trace_put_int(const char *key, long long value) {
+  struct va_trace_attr *a = va_trace_attr(key, VA_TRACE_INT);
+  if (a) {
+    a->v.i = value;
+  }
+}
+
+void va_trace_put_uint(const char *key, unsigned long long value) {
+  struct va_trace_attr *a = va_trace_attr(key, VA_TRACE_UINT);
+  if (a) {
+    a->v.u = value;
+  }
+}
+
+void va_trace_put_double(const char *key, double value) {
+  struct va_trace_attr *a = va_trace_attr(key, VA_TRACE_DOUBLE);
+  if (a) {
+    a->v.d = value;
+  }
+}
+
+void va_trace_put_string(const char *key, const char *value) {
+  struct va_trace_buffer *b = va_trace_buffer();
+  size_t n = strlen(value ? value : "") + 1;
+  struct va_trace_attr *a;
+  if (!b || n > VA_TRACE_MAX_STRINGS - b->nstrings) {
+    if (b) {
+      b->dropped++;
+    }
+    return;
+  }
+  a = va_trace_attr(key, VA_TRACE_STRING);
+  if (a) {
+    memcpy(b->strings + b->nstrings, value ? value : "", n);
+    a->v.s = b->nstrings;
+    b->nstrings += (unsigned)n;
+  }
+}
+
+static void va_trace_push(const char *name, unsigned long long ts,
+                          unsigned long long dur, unsigned attrs,
+                          unsigned nattrs, char phase) {
+  struct va_trace_buffer *b = va_trace_buffer();
+  struct va_trace_event *e;
+  if (!b || b->nevents == VA_TRACE_MAX_EVENTS) {
+    if (b) {
+      b->dropped++;
+    }
+    return;
+  }
+  e = &b->events[b->nevents++];
+  e->name = name;
+  e->ts = ts;
+  e->dur = dur;
+  e->attrs = attrs;
+  e->nattrs = nattrs;
+  e->phase = phase;
+}
+
+void va_trace_end(struct va_trace_span *span) {
+  unsigned long long end = va_trace_now();
+  va_trace_push(span->name, span->start, end - span->start, span->attrs,
+                span->nattrs, 'X');
+}
+
+void va_trace_instant(const char *name, unsigned attrs, unsigned nattrs) {
+  va_trace_push(name, va_trace_now(), 0, attrs, nattrs, 'i');
+}
+
+static void va_trace_json_string(FILE *out, const char *s) {
+  fputc('"', out);
+  for (; *s; s++) {
+    unsigned char c = (unsigned char)*s;
+    if (c == '"' || c == '\\') {
+      fprintf(out, "\\%c", c);
+    } else if (c < 0x20) {
+      fprintf(out, "\\u%04x", c);
+    } else {
+      fputc(c, out);
+    }
+  }
+  fputc('"', out);
+}
+
+int va_trace_write(FILE *out) {
+  struct va_trace_buffer *b;
+  const char *sep = "\n";
+  long pid = (long)getpid();
+  unsigned i, k;
+  fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", out);
+  pthread_mutex_lock(&va_trace_lock_);
+  for (b = va_trace_buffers_; b; b = b->next) {
+    for (i = 0; i < b->nevents; i++) {
+      const struct va_trace_event *e = &b->events[i];
+      fputs(sep, out);
+      sep = ",\n";
+      fputs("{\"name\":", out);
+      va_trace_json_string(out, e->name);
+      fprintf(out, ",\"ph\":\"%c\",\"ts\":%llu.%03llu,", e->phase,
+              e->ts / 1000, e->ts % 1000);
+      if (e->phase == 'X') {
+        fprintf(out, "\"dur\":%llu.%03llu,", e->dur / 1000, e->dur % 1000);
+      } else {
+        fputs("\"s\":\"t\",", out);
+      }
+      fprintf(out, "\"pid\":%ld,\"tid\":%u", pid, b->tid);
+      if (e->nattrs) {
+        fputs(",\"args\":{", out);
+        for (k = 0; k < e->nattrs; k++) {
+          const struct va_trace_attr *a = &b->attrs[e->attrs + k];
+          fputs(k ? "," : "", out);
+          va_trace_json_string(out, a->key);
+          fputc(':', out);
+          if (a->tag == VA_TRACE_INT) {
+            fprintf(out, "%lld", a->v.i);
+          } else if (a->tag == VA_TRACE_UINT) {
+            fprintf(out, "%llu", a->v.u);
+          } else if (a->tag == VA_TRACE_DOUBLE && !isfinite(a->v.d)) {
+            fputs("null", out); /* JSON has no NaN or infinity */
+          } else if (a->tag == VA_TRACE_DOUBLE) {
+            fprintf(out, "%.17g", a->v.d);
+          } else {
+            va_trace_json_string(out, b->strings + a->v.s);
+          }
+        }
+        fputc('}', out);
+      }
+      fputc('}', out);
+    }
+  }
+  pthread_mutex_unlock(&va_trace_lock_);
+  fputs("\n]}\n", out);
+  return ferror(out) ? -1 : 0;
+}
+
+void va_trace_reset(void) {
+  struct va_trace_buffer *b;
+  pthread_mutex_lock(&va_trace_lock_);
+  for (b = va_trace_buffers_; b; b = b->next) {
+    b->nevents = b->nattrs = b->nstrings = 0;
+    b->dropped = 0;
+  }
+  pthread_mutex_unlock(&va_trace_lock_);
+}
+
+unsigned long va_trace_dropped(void) {
+  struct va_trace_buffer *b;
+  unsigned long n = 0;
+  pthread_mutex_lock(&va_trace_lock_);
+  for (b = va_trace_buffers_; b; b = b->next) {
+    n += b->dropped;
+  }
+  pthread_mutex_unlock(&va_trace_lock_);
+  return n;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* VA_TRACE_IMPLEMENTATION */
+
+#ifdef TEST_VA_TRACE
+#define NTRNLVA_TEST
+#include "va_internal.h"
+
+#define TEST_STR_I(...) #__VA_ARGS__
+#define TEST_STR(...) TEST_STR_I(__VA_ARGS__)
+
+/* Writes the trace and returns it; the caller frees it */
+static char *trace_json(void) {
+  FILE *f = tmpfile();
+  long size;
+  char *text;
+  va_trace_write(f);
+  size = ftell(f);
+  rewind(f);
+  text = (char *)calloc(1, (size_t)size + 1);
+  if (fread(text, 1, (size_t)size, f) != (size_t)size) {
+    text[0] = '\0';
+  }
+  fclose(f);
+  return text;
+}
+
+static int count(const char *text, const char *needle) {
+  int n = 0;
+  for (; (text = strstr(text, needle)) != NULL; text++) {
+    n++;
+  }
+  return n;
+}
+
+#ifdef VA_TRACE_DISABLE
+/* Nothing of the call is left, so the arguments cannot be evaluated. The
+array size is negative, failing the build, if any tokens remain. */
+typedef char trace_scope_disabled
+    [sizeof(TEST_STR(VA_TRACE_SCOPE("s", ("k", side_effect())))) ==
+             sizeof("((void)0)")
+         ? 1
+         : -1];
+typedef char trace_event_disabled
+    [sizeof(TEST_STR(VA_TRACE_EVENT("e", ("k", side_effect())))) ==
+             sizeof("((void)0)")
+         ? 1
+         : -1];
+
+int main(void) {
+  char *json;
+  {
+    VA_TRACE_SCOPE("eval", ("x", side_effect()));
+    VA_TRACE_EVENT("eval", ("x", side_effect()));
+  }
+  EXPECT(side_effect(), 1); /* the first evaluation is this one */
+  EXPECT(strcmp(TEST_STR(VA_TRACE_SCOPE("s", ("k", 1))), "((void)0)"), 0);
+  json = trace_json();
+  EXPECT(count(json, "\"name\""), 0);
+  free(json);
+#else
+static void *trace_thread(void *unused) {
+  int i;
+  (void)unused;
+  for (i = 0; i < 100; i++) {
+    VA_TRACE_SCOPE("worker", ("i", i));
+  }
+  return NULL;
+}
+
+int main(void) {
+  char *json;
+  char path[16] = "a.txt";
+  pthread_t threads[2];
+  int i;
+
+  {
+    VA_TRACE_SCOPE("outer");
+    {
+      VA_TRACE_SCOPE("inner", ("file", path), ("n", 3), ("ratio", 0.5));
+      path[0] = 'X'; /* strings are copied */
+      VA_TRACE_EVENT("tick");
+      VA_TRACE_EVENT("hit", ("key", "k\"1"), ("wide", 0.25L));
+      VA_TRACE_EVENT("edge", ("max", ~0ull), ("inf", -HUGE_VAL), ("nan", NAN));
+    }
+  }
+  json = trace_json();
+  EXPECT(count(json, "\"name\":\"outer\",\"ph\":\"X\""), 1);
+  EXPECT(count(json, "\"name\":\"inner\",\"ph\":\"X\""), 1);
+  EXPECT(count(json, "\"args\":{\"file\":\"a.txt\",\"n\":3,\"ratio\":0.5}"),
+         1);
+  EXPECT(count(json, "\"name\":\"tick\",\"ph\":\"i\""), 1);
+  EXPECT(count(json, "\"args\":{\"key\":\"k\\\"1\",\"wide\":0.25}"), 1);
+  /* Unsigned values keep their sign; JSON has null for NaN and infinity */
+  EXPECT(count(json, "\"args\":{\"max\":18446744073709551615,\"inf\":null,"
+                     "\"nan\":null}"),
+         1);
+  EXPECT(count(json, "\"args\""), 3);
+  /* Spans are written when they end: inner, then outer */
+  EXPECT(strstr(json, "\"inner\"") < strstr(json, "\"outer\""), 1);
+  free(json);
+
+  va_trace_reset();
+  for (i = 0; i < 2; i++) {
+    pthread_create(&threads[i], NULL, trace_thread, NULL);
+  }
+  for (i = 0; i < 2; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  json = trace_json();
+  EXPECT(count(json, "\"name\":\"worker\""), 200);
+  EXPECT(count(json, "\"args\":{\"i\":99}"), 2);
+  EXPECT(count(json, "\"outer\""), 0);
+  free(json);
+  EXPECT((int)va_trace_dropped(), 0);
+
+  /* Attributes are evaluated once, when the span opens */
+  {
+    VA_TRACE_SCOPE("eval", ("x", side_effect()));
+  }
+  EXPECT(evaluated, 1);
+
+  /* Two scopes on one line get their own variables */
+  va_trace_reset();
+  { VA_TRACE_SCOPE("first"); VA_TRACE_SCOPE("second", ("n", 2)); }
+  json = trace_json();
+  EXPECT(count(json, "\"name\":\"first\""), 1);
+  EXPECT(count(json, "\"name\":\"second\""), 1);
+  free(json);
+#endif /* VA_TRACE_DISABLE */
+
+  return test_report();
+}
+#endif /* TEST_VA_TRACE */
+
+#endif /* VA_TRACE_H */